@@ -10,27 +10,64 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    alphascan.cpp \
     backgrounddialog.cpp \
     desktopiconmodel.cpp \
+    directoryindex.cpp \
+    fileidentity.cpp \
     filesystemmodel.cpp \
+    iconcache.cpp \
+    iconclassifier.cpp \
+    iconloader.cpp \
+    iconpack.cpp \
+    iconprovider.cpp \
+    iconresolver.cpp \
     iconview.cpp \
     imagebutton.cpp \
     itemdelegate.cpp \
+    itemsnapshot.cpp \
     main.cpp \
     mainwindow.cpp \
+    mimecache.cpp \
+    mipchain.cpp \
     multidirmodel.cpp \
-    sortmodel.cpp
+    sortmodel.cpp \
+    trigramindex.cpp \
+    updatescheduler.cpp
 
 HEADERS += \
+    alphascan.h \
     backgrounddialog.h \
     desktopiconmodel.h \
+    desktopitemsource.h \
+    directoryindex.h \
+    fileidentity.h \
     filesystemmodel.h \
+    iconcache.h \
+    iconclassifier.h \
+    iconloader.h \
+    iconpack.h \
+    iconprovider.h \
+    iconresolver.h \
     iconview.h \
     imagebutton.h \
     itemdelegate.h \
+    itemsnapshot.h \
     mainwindow.h \
+    mimecache.h \
+    mipchain.h \
     multidirmodel.h \
-    sortmodel.h
+    sortmodel.h \
+    trigramindex.h \
+    updatescheduler.h
+
+win32 {
+    SOURCES += win32iconprovider.cpp
+    HEADERS += win32iconprovider.h
+} else {
+    SOURCES += xdgiconprovider.cpp
+    HEADERS += xdgiconprovider.h
+}
 
 FORMS += \
     backgrounddialog.ui \
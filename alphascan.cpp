@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "alphascan.h"
+#include <QtAlgorithms>
+#include <climits>
+
+#if defined( Q_PROCESSOR_X86_64 ) || defined( __SSE2__ )
+#define ALPHASCAN_SSE2
+#include <emmintrin.h>
+#if defined( Q_CC_MSVC ) || defined( Q_CC_GNU )
+#define ALPHASCAN_AVX2
+#include <immintrin.h>
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#define ALPHASCAN_TARGET_AVX2
+#else
+#define ALPHASCAN_TARGET_AVX2 __attribute__(( target( "avx2" )))
+#endif
+#endif
+#endif
+
+/*
+ * alpha byte of a 32-bit pixel
+ */
+static constexpr const quint32 AlphaMask = 0xff000000u;
+
+/**
+ * @brief firstOpaqueScalar
+ * @param row
+ * @param count
+ * @return
+ */
+static int firstOpaqueScalar( const quint32 *row, int count ) {
+    for ( int x = 0; x < count; x++ ) {
+        if ( row[x] & AlphaMask )
+            return x;
+    }
+    return -1;
+}
+
+/**
+ * @brief lastOpaqueScalar
+ * @param row
+ * @param count
+ * @return
+ */
+static int lastOpaqueScalar( const quint32 *row, int count ) {
+    for ( int x = count - 1; x >= 0; x-- ) {
+        if ( row[x] & AlphaMask )
+            return x;
+    }
+    return -1;
+}
+
+#ifdef ALPHASCAN_SSE2
+/**
+ * @brief opaqueMaskSse2 returns one bit per pixel with non-zero alpha
+ * @param pixels
+ * @return
+ */
+static inline quint32 opaqueMaskSse2( const quint32 *pixels ) {
+    const __m128i mask = _mm_set1_epi32( static_cast<int>( AlphaMask ));
+    const __m128i data = _mm_and_si128( _mm_loadu_si128( reinterpret_cast<const __m128i *>( pixels )), mask );
+    return ~static_cast<quint32>( _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpeq_epi32( data, _mm_setzero_si128())))) & 0xfu;
+}
+
+/**
+ * @brief firstOpaqueSse2
+ * @param row
+ * @param count
+ * @return
+ */
+static int firstOpaqueSse2( const quint32 *row, int count ) {
+    int x = 0;
+
+    for ( ; x + 4 <= count; x += 4 ) {
+        const quint32 bits = opaqueMaskSse2( row + x );
+        if ( bits )
+            return x + static_cast<int>( qCountTrailingZeroBits( bits ));
+    }
+
+    const int tail = firstOpaqueScalar( row + x, count - x );
+    return tail == -1 ? -1 : x + tail;
+}
+
+/**
+ * @brief lastOpaqueSse2
+ * @param row
+ * @param count
+ * @return
+ */
+static int lastOpaqueSse2( const quint32 *row, int count ) {
+    int x = count;
+
+    for ( ; x >= 4; x -= 4 ) {
+        const quint32 bits = opaqueMaskSse2( row + x - 4 );
+        if ( bits )
+            return x - 4 + 31 - static_cast<int>( qCountLeadingZeroBits( bits ));
+    }
+
+    return lastOpaqueScalar( row, x );
+}
+#endif
+
+#ifdef ALPHASCAN_AVX2
+/**
+ * @brief opaqueMaskAvx2 returns one bit per pixel with non-zero alpha
+ * @param pixels
+ * @return
+ */
+ALPHASCAN_TARGET_AVX2 static inline quint32 opaqueMaskAvx2( const quint32 *pixels ) {
+    const __m256i mask = _mm256_set1_epi32( static_cast<int>( AlphaMask ));
+    const __m256i data = _mm256_and_si256( _mm256_loadu_si256( reinterpret_cast<const __m256i *>( pixels )), mask );
+    return ~static_cast<quint32>( _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_cmpeq_epi32( data, _mm256_setzero_si256())))) & 0xffu;
+}
+
+/**
+ * @brief firstOpaqueAvx2
+ * @param row
+ * @param count
+ * @return
+ */
+ALPHASCAN_TARGET_AVX2 static int firstOpaqueAvx2( const quint32 *row, int count ) {
+    int x = 0;
+
+    for ( ; x + 8 <= count; x += 8 ) {
+        const quint32 bits = opaqueMaskAvx2( row + x );
+        if ( bits )
+            return x + static_cast<int>( qCountTrailingZeroBits( bits ));
+    }
+
+    const int tail = firstOpaqueSse2( row + x, count - x );
+    return tail == -1 ? -1 : x + tail;
+}
+
+/**
+ * @brief lastOpaqueAvx2
+ * @param row
+ * @param count
+ * @return
+ */
+ALPHASCAN_TARGET_AVX2 static int lastOpaqueAvx2( const quint32 *row, int count ) {
+    int x = count;
+
+    for ( ; x >= 8; x -= 8 ) {
+        const quint32 bits = opaqueMaskAvx2( row + x - 8 );
+        if ( bits )
+            return x - 8 + 31 - static_cast<int>( qCountLeadingZeroBits( bits ));
+    }
+
+    return lastOpaqueSse2( row, x );
+}
+
+/**
+ * @brief hasAvx2
+ * @return
+ */
+static bool hasAvx2() {
+#ifdef Q_CC_MSVC
+    int info[4];
+
+    __cpuid( info, 0 );
+    if ( info[0] < 7 )
+        return false;
+
+    // AVX registers must also be enabled by the OS
+    __cpuid( info, 1 );
+    if (( info[2] & ( 1 << 27 )) == 0 || ( info[2] & ( 1 << 28 )) == 0 || ( _xgetbv( 0 ) & 6 ) != 6 )
+        return false;
+
+    __cpuidex( info, 7, 0 );
+    return ( info[1] & ( 1 << 5 )) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+#endif
+}
+#endif
+
+/**
+ * @brief The Kernels struct
+ */
+struct Kernels {
+    AlphaScan::Kernel kernel;
+    int ( *first )( const quint32 *, int );
+    int ( *last )( const quint32 *, int );
+};
+
+/**
+ * @brief kernelsFor
+ * @param kernel
+ * @return the given kernel, scalar if it was not compiled in
+ */
+static Kernels kernelsFor( AlphaScan::Kernel kernel ) {
+    switch ( kernel ) {
+    case AlphaScan::AVX2:
+#ifdef ALPHASCAN_AVX2
+        return { AlphaScan::AVX2, firstOpaqueAvx2, lastOpaqueAvx2 };
+#else
+        break;
+#endif
+
+    case AlphaScan::SSE2:
+#ifdef ALPHASCAN_SSE2
+        return { AlphaScan::SSE2, firstOpaqueSse2, lastOpaqueSse2 };
+#else
+        break;
+#endif
+
+    case AlphaScan::Scalar:
+        break;
+    }
+
+    return { AlphaScan::Scalar, firstOpaqueScalar, lastOpaqueScalar };
+}
+
+/**
+ * @brief kernels picks the widest kernel the CPU supports
+ * @return
+ */
+static const Kernels &kernels() {
+    static const Kernels selected = []() -> Kernels {
+#ifdef ALPHASCAN_AVX2
+        if ( hasAvx2())
+            return kernelsFor( AlphaScan::AVX2 );
+#endif
+        return kernelsFor( AlphaScan::SSE2 );
+    }();
+
+    return selected;
+}
+
+/**
+ * @brief AlphaScan::kernel
+ * @return
+ */
+AlphaScan::Kernel AlphaScan::kernel() {
+    return kernels().kernel;
+}
+
+/**
+ * @brief AlphaScan::isSupported
+ * @param kernel
+ * @return true if the kernel is compiled in and the CPU can run it
+ */
+bool AlphaScan::isSupported( Kernel kernel ) {
+    if ( kernel == AVX2 ) {
+#ifdef ALPHASCAN_AVX2
+        return hasAvx2();
+#else
+        return false;
+#endif
+    }
+
+    return kernelsFor( kernel ).kernel == kernel;
+}
+
+/**
+ * @brief AlphaScan::firstOpaque
+ * @param row
+ * @param count
+ * @return index of the first pixel with non-zero alpha or -1
+ */
+int AlphaScan::firstOpaque( const quint32 *row, int count ) {
+    return kernels().first( row, count );
+}
+
+/**
+ * @brief AlphaScan::lastOpaque
+ * @param row
+ * @param count
+ * @return index of the last pixel with non-zero alpha or -1
+ */
+int AlphaScan::lastOpaque( const quint32 *row, int count ) {
+    return kernels().last( row, count );
+}
+
+/**
+ * @brief AlphaScan::firstOpaque runs a specific kernel, which must be supported
+ * @param kernel
+ * @param row
+ * @param count
+ * @return
+ */
+int AlphaScan::firstOpaque( Kernel kernel, const quint32 *row, int count ) {
+    return kernelsFor( kernel ).first( row, count );
+}
+
+/**
+ * @brief AlphaScan::lastOpaque runs a specific kernel, which must be supported
+ * @param kernel
+ * @param row
+ * @param count
+ * @return
+ */
+int AlphaScan::lastOpaque( Kernel kernel, const quint32 *row, int count ) {
+    return kernelsFor( kernel ).last( row, count );
+}
+
+/**
+ * @brief AlphaScan::opaqueBounds
+ * @param image
+ * @param rect area to scan, whole image if null
+ * @return bounding box of all pixels with non-zero alpha, null if blank
+ */
+QRect AlphaScan::opaqueBounds( const QImage &image, const QRect &rect ) {
+    const bool native = image.format() == QImage::Format_ARGB32_Premultiplied || image.format() == QImage::Format_ARGB32 || image.format() == QImage::Format_RGB32;
+    const QImage source( native ? image : image.convertToFormat( QImage::Format_ARGB32_Premultiplied ));
+    const QRect area( rect.isNull() ? source.rect() : ( rect & source.rect()));
+    const Kernels &scan = kernels();
+    int left = INT_MAX, right = -1, top = -1, bottom = -1;
+
+    if ( area.isEmpty())
+        return QRect();
+
+    for ( int y = area.top(); y <= area.bottom(); y++ ) {
+        const quint32 *row = reinterpret_cast<const quint32 *>( source.constScanLine( y )) + area.left();
+        const int first = scan.first( row, area.width());
+        if ( first == -1 )
+            continue;
+
+        left = qMin( left, first );
+        right = qMax( right, scan.last( row, area.width()));
+
+        if ( top == -1 )
+            top = y;
+        bottom = y;
+    }
+
+    if ( top == -1 )
+        return QRect();
+
+    return QRect( QPoint( area.left() + left, top ), QPoint( area.left() + right, bottom ));
+}
+
+/**
+ * @brief AlphaScan::isJumbo tells a real jumbo shell icon from a padded smaller one
+ * @param image
+ * @return false for icons with nothing past the top left 64x64 pixels (a 48x48 icon
+ * on a blank jumbo canvas) and for 256x256 icons that only fill the center [64,191]
+ */
+bool AlphaScan::isJumbo( const QImage &image ) {
+    const int cropScale = 64;
+    if ( image.width() < cropScale || image.height() < cropScale )
+        return false;
+
+    // something must be at or beyond cropScale on both axes
+    const QRect bounds( AlphaScan::opaqueBounds( image ));
+    if ( bounds.isNull())
+        return false;
+
+    if ( bounds.left() < cropScale || bounds.top() < cropScale ) {
+        if ( bounds.right() < cropScale || bounds.bottom() < cropScale )
+            return false;
+
+        if ( AlphaScan::opaqueBounds( image, QRect( cropScale, cropScale, image.width() - cropScale, image.height() - cropScale )).isNull())
+            return false;
+    }
+
+    // a small, but centered icon has nothing within cropScale pixels of any side
+    return image.width() != 256 || image.height() != 256 ||
+            bounds.left() < cropScale || bounds.top() < cropScale || bounds.right() >= 256 - cropScale || bounds.bottom() >= 256 - cropScale;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QImage>
+#include <QRect>
+
+/**
+ * @brief The AlphaScan namespace holds scanline kernels for alpha coverage
+ *
+ * Rows are scanned as 32-bit pixels (ARGB32, ARGB32_Premultiplied, RGB32);
+ * other formats are converted first. AVX2 or SSE2 kernels are picked at
+ * runtime when the CPU has them, otherwise a scalar loop is used.
+ */
+namespace AlphaScan {
+enum Kernel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+Kernel kernel();
+bool isSupported( Kernel kernel );
+int firstOpaque( const quint32 *row, int count );
+int lastOpaque( const quint32 *row, int count );
+int firstOpaque( Kernel kernel, const quint32 *row, int count );
+int lastOpaque( Kernel kernel, const quint32 *row, int count );
+QRect opaqueBounds( const QImage &image, const QRect &rect = QRect());
+bool isJumbo( const QImage &image );
+}
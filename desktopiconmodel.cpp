@@ -20,37 +20,33 @@
  * includes
  */
 #include "desktopiconmodel.h"
+#include "iconcache.h"
+#include "iconprovider.h"
+#include "mipchain.h"
 #include "multidirmodel.h"
 #include <QDebug>
-#ifdef Q_OS_WIN
-#include <QtWin>
-#include <Windows.h>
-#include <CommCtrl.h>
-#include <commoncontrols.h>
-#include <shellapi.h>
-#include <WinUser.h>
 #include <QStandardPaths>
-#endif
 
 /**
  * @brief DesktopIconModel::DesktopIconModel
  * @param parent
  */
 DesktopIconModel::DesktopIconModel( QObject *parent ) : QAbstractListModel( parent ) {
-    const QDir dir( "cache/" );
-    if ( !dir.exists())
-        dir.mkpath( "." );
+    IconResolver::connect( this->icons, &IconResolver::loaded, this, &DesktopIconModel::iconLoaded );
+    DesktopIconModel::connect( this, &DesktopIconModel::modelAboutToBeReset, this->icons, &IconResolver::clear );
 }
 
 /**
  * @brief DesktopIconModel::setScale
- * @param scale
+ * @param scale icon size in logical pixels
+ * @param devicePixelRatio of the screen the icons are shown on
  */
-void DesktopIconModel::setScale( int scale ) {
-    this->beginResetModel();
-    this->iconCache.clear();
-    this->m_scale = scale;
-    this->endResetModel();
+void DesktopIconModel::setScale( int scale, qreal devicePixelRatio ) {
+    if ( !this->icons->setScale( scale, devicePixelRatio ))
+        return;
+
+    // icons are resampled from cached mip chains, no need to reset
+    emit this->dataChanged( this->index( 0, 0 ), this->index( this->rowCount() - 1, 0 ), QVector<int>() << Qt::DecorationRole << IconRoles::PixmapRole );
 }
 
 /**
@@ -74,6 +70,9 @@ QVariant DesktopIconModel::data( const QModelIndex &index, int role ) const {
     if ( role == Qt::DecorationRole )
         return this->fileIcon( index );
 
+    if ( role == IconRoles::PixmapRole )
+        return this->filePixmap( index );
+
     return QVariant();
 }
 
@@ -135,84 +134,105 @@ QString DesktopIconModel::mimeTypeName( const QModelIndex &index ) const {
 }
 
 /**
- * @brief DesktopIconModel::fileIcon
+ * @brief DesktopIconModel::partialItem
+ * @param row
  * @return
  */
-QIcon DesktopIconModel::fileIcon( const QModelIndex &index ) const {
-    int iconId = -1;
+DesktopItem DesktopIconModel::partialItem( int row ) const {
+    const QModelIndex index( this->index( row, 0 ));
+
+    DesktopItem item;
+    item.name = this->fileName( index );
+    item.path = this->filePath( index );
+    item.size = this->size( index );
+    item.lastModified = this->lastModified( index );
+    item.type = this->mimeTypeName( index );
+    item.flags = this->flags( index );
+    return item;
+}
 
-    switch ( index.row()) {
+/**
+ * @brief DesktopIconModel::iconId
+ * @param row
+ * @return
+ */
+int DesktopIconModel::iconId( int row ) {
+    switch ( row ) {
     case 0:
-        iconId = 16;
-        break;
+        return 16;
 
     case 1:
-        iconId = 32;
-        break;
+        return 32;
 
     case 2:
-        iconId = 267;
-        break;
+        return 267;
     }
 
-    if ( this->iconCache.contains( iconId ))
-        return this->iconCache[iconId];
-
-    QPixmap pixmap;
-    if ( pixmap.load( QString( "cache/%1_%2.png" ).arg( QString::number( iconId ), QString::number( this->scale()))))
-        return QIcon( pixmap );
-
-    return this->getIcon( iconId );
+    return -1;
 }
 
 /**
- * @brief DesktopIconModel::getIconPixmap
+ * @brief DesktopIconModel::cacheKey
+ * @param iconId
  * @return
  */
-QPixmap DesktopIconModel::getIconPixmap( int iconId, int scale ) {
-    return DesktopIconModel::loadPixmapFromLibrary( iconId, scale );
+QString DesktopIconModel::cacheKey( int iconId ) {
+    return QString( "shell32_%1" ).arg( iconId );
 }
 
 /**
- * @brief DesktopIconModel::loadPixmapFromLibrary
- * @param resourceId
- * @param scale
- * @param name
- * @return
+ * @brief DesktopIconModel::fallbackType
+ * @param iconId
+ * @return generic icon shown when extraction fails
  */
-QPixmap DesktopIconModel::loadPixmapFromLibrary( int resourceId, int scale, const QString &name )  {
-    auto loadLibrary = []( const wchar_t *libraryName )  {
-        QVarLengthArray<wchar_t, MAX_PATH> fullPath;
+QFileIconProvider::IconType DesktopIconModel::fallbackType( int iconId ) {
+    switch ( iconId ) {
+    case 16:
+        return QFileIconProvider::Computer;
 
-        UINT retLen = ::GetSystemDirectory( fullPath.data(), MAX_PATH );
-        if ( retLen > MAX_PATH ) {
-            fullPath.resize( static_cast<int>( retLen ));
-            retLen = ::GetSystemDirectory( fullPath.data(), retLen );
-        }
+    case 32:
+        return QFileIconProvider::Trashcan;
+    }
 
-        const QString systemDirectory( QString::fromWCharArray( fullPath.constData(), static_cast<int>( retLen )));
-        HINSTANCE inst = nullptr;
-        if ( !systemDirectory.isEmpty()) {
-            const QString fileName( QString::fromWCharArray( libraryName ).append( QLatin1String(".dll" )));
-            const QString absolutePath( systemDirectory + ( !systemDirectory.endsWith( "\\" ) ? "\\" : "" ) + fileName );
+    return QFileIconProvider::Folder;
+}
 
-            inst = ::LoadLibrary( reinterpret_cast<const wchar_t *>( absolutePath.utf16()));
-            if ( inst != nullptr )
-                return inst;
-        }
+/**
+ * @brief DesktopIconModel::filePixmap
+ * @return icon at the exact pixel size of the view, null until extracted
+ */
+QPixmap DesktopIconModel::filePixmap( const QModelIndex &index ) const {
+    const int iconId = DesktopIconModel::iconId( index.row());
+    return this->icons->pixmap( DesktopIconModel::cacheKey( iconId ), [ iconId ]() { return DesktopIconModel::getIconImage( iconId ); }, DesktopIconModel::fallbackType( iconId ));
+}
 
-        return inst;
-    };
+/**
+ * @brief DesktopIconModel::fileIcon
+ * @param index
+ * @return cached icon only, extraction is requested through filePixmap
+ */
+QIcon DesktopIconModel::fileIcon( const QModelIndex &index ) const {
+    const QPixmap pixmap( this->icons->cached( DesktopIconModel::cacheKey( DesktopIconModel::iconId( index.row()))));
+    return pixmap.isNull() ? QIcon() : QIcon( pixmap );
+}
 
-    if ( const HMODULE hmod = loadLibrary( reinterpret_cast<const wchar_t*>( QDir::toNativeSeparators( name ).utf16()))) {
-        const HICON hIcon = static_cast<HICON>( LoadImage( hmod, MAKEINTRESOURCE( resourceId ), IMAGE_ICON, scale, scale, 0 ));
-        if ( hIcon != nullptr ) {
-            const QPixmap pixmap( QtWin::fromHICON( hIcon ));
-            DestroyIcon( hIcon );
-            return pixmap;
-        }
-    }
-    return QPixmap();
+/**
+ * @brief DesktopIconModel::getIconImage
+ * @return icon at the largest mip chain size
+ */
+QImage DesktopIconModel::getIconImage( int iconId ) {
+    return DesktopIconModel::loadImageFromLibrary( iconId, MipChain::Levels[0] );
+}
+
+/**
+ * @brief DesktopIconModel::loadImageFromLibrary
+ * @param resourceId
+ * @param scale
+ * @param name
+ * @return
+ */
+QImage DesktopIconModel::loadImageFromLibrary( int resourceId, int scale, const QString &name )  {
+    return IconProvider::instance()->libraryImage( resourceId, scale, name );
 }
 
 /**
@@ -236,19 +256,14 @@ qint64 DesktopIconModel::size( const QModelIndex &index ) const {
 }
 
 /**
- * @brief DesktopIconModel::getIcon
- * @param info
- * @return
+ * @brief DesktopIconModel::iconLoaded
+ * @param key
  */
-QIcon DesktopIconModel::getIcon( int iconId ) const {
-    const QPixmap pixmap( DesktopIconModel::getIconPixmap( iconId, this->scale()));
-    const QIcon icon( pixmap );
-    this->iconCache[iconId] = icon;
-
-    if ( !icon.isNull()) {
-        qDebug() << "DesktopIconModel: write cache";
-        pixmap.save( QString( "cache/%1_%2.png" ).arg( QString::number( iconId ), QString::number( this->scale())));
+void DesktopIconModel::iconLoaded( const QString &key ) {
+    for ( int y = 0; y < this->rowCount(); y++ ) {
+        if ( DesktopIconModel::cacheKey( DesktopIconModel::iconId( y )) == key ) {
+            const QModelIndex index( this->index( y, 0 ));
+            emit this->dataChanged( index, index, QVector<int>() << Qt::DecorationRole << IconRoles::PixmapRole );
+        }
     }
-
-    return icon;
 }
@@ -21,7 +21,9 @@
 /*
  * includes
  */
-#include "filesystemmodel.h"
+#include "desktopitemsource.h"
+#include "iconresolver.h"
+#include <QFileIconProvider>
 #include <QFileInfo>
 #include <QIcon>
 #include <QTime>
@@ -37,7 +39,7 @@ namespace DesktopIcons {
 /**
  * @brief The DesktopIconModel class
  */
-class DesktopIconModel : public QAbstractListModel {
+class DesktopIconModel : public QAbstractListModel, public DesktopItemSource {
     Q_OBJECT
 
 public:
@@ -51,18 +53,28 @@ public:
     QString fileName( const QModelIndex & ) const;
     QString filePath( const QModelIndex & ) const;
     QString mimeTypeName( const QModelIndex & ) const;
-    QIcon fileIcon( const QModelIndex & ) const;
-    int scale() const { return this->m_scale; }
-    QIcon getIcon( int iconId ) const;
-    static QPixmap getIconPixmap( int iconId, int scale = 48 );
-    static QPixmap loadPixmapFromLibrary( int resourceId, int scale, const QString &name = "shell32" );
+    QIcon fileIcon( const QModelIndex &index ) const;
+    QPixmap filePixmap( const QModelIndex &index ) const;
+    int scale() const { return this->icons->scale(); }
+    qreal devicePixelRatio() const { return this->icons->devicePixelRatio(); }
+    int pixelSize() const { return this->icons->pixelSize(); }
+    static QImage getIconImage( int iconId );
+    static QImage loadImageFromLibrary( int resourceId, int scale, const QString &name = "shell32" );
+    static QPixmap loadPixmapFromLibrary( int resourceId, int scale, const QString &name = "shell32" ) { return QPixmap::fromImage( DesktopIconModel::loadImageFromLibrary( resourceId, scale, name )); }
     qint64 size( const QModelIndex &index ) const;
     QDateTime lastModified( const QModelIndex & ) const { return QDateTime(); }
+    QAbstractItemModel *model() override { return this; }
+    DesktopItem partialItem( int row ) const override;
 
 public slots:
-    void setScale( int scale );
+    void setScale( int scale, qreal devicePixelRatio = 1.0 ) override;
+
+private slots:
+    void iconLoaded( const QString &key );
 
 private:
-    mutable QMap<int,QIcon> iconCache;
-    int m_scale = 48; // TODO: copy from ListView
+    static int iconId( int row );
+    static QString cacheKey( int iconId );
+    static QFileIconProvider::IconType fallbackType( int iconId );
+    IconResolver *icons = new IconResolver( this );
 };
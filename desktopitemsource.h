@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QAbstractItemModel>
+#include <QDateTime>
+
+/**
+ * @brief The DesktopItem struct holds everything the desktop needs to know about an item
+ */
+struct DesktopItem {
+    QString name;
+    QString path;
+    qint64 size = -1;
+    QDateTime lastModified;
+    QString type;
+    Qt::ItemFlags flags;
+
+    /**
+     * @brief displayName is the name shown, sorted and searched by every source
+     * @param fileName
+     * @return file name without the shortcut suffix
+     */
+    static QString displayName( const QString &fileName ) { return fileName.endsWith( ".lnk" ) ? fileName.left( fileName.length() - 4 ) : fileName; }
+};
+
+/**
+ * @brief The DesktopItemSource class is implemented by models that MultiDirModel merges
+ *
+ * Rows are flat: item( row ) describes model()->index( row, 0 ), whose
+ * parent is rootIndex() in the model's own terms. An item is read in two
+ * steps: partialItem() copies what the model already holds and must run on
+ * the GUI thread, completeItem() fills in the rest (such as the type) from
+ * the item alone and may run on any thread.
+ */
+class DesktopItemSource {
+public:
+    virtual ~DesktopItemSource() = default;
+    virtual QAbstractItemModel *model() = 0;
+    virtual QModelIndex rootIndex() const { return QModelIndex(); }
+    virtual DesktopItem partialItem( int row ) const = 0;
+    virtual void completeItem( DesktopItem & ) const {}
+    virtual void setScale( int scale, qreal devicePixelRatio ) = 0;
+
+    DesktopItem item( int row ) const {
+        DesktopItem item( this->partialItem( row ));
+        this->completeItem( item );
+        return item;
+    }
+};
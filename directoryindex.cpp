@@ -0,0 +1,665 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "directoryindex.h"
+#include "iconcache.h"
+#include "mimecache.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QSet>
+#include <QSettings>
+#include <QtConcurrent>
+#if defined( Q_OS_LINUX )
+#include <QSocketNotifier>
+#include <atomic>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined( Q_OS_WIN )
+#include <QWinEventNotifier>
+#else
+#include <QDirIterator>
+#include <QFileSystemWatcher>
+#endif
+
+/*
+ * directory index diagnostics, enable with QT_LOGGING_RULES="desktopview.index.debug=true"
+ */
+Q_LOGGING_CATEGORY( indexLog, "desktopview.index", QtInfoMsg )
+
+#if defined( Q_OS_LINUX )
+/**
+ * @brief The Dirent64 struct is the record layout of getdents64
+ */
+struct Dirent64 {
+    quint64 d_ino;
+    qint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+/**
+ * @brief statEntry
+ * @param dir directory descriptor name is relative to
+ * @param name
+ * @param size
+ * @param lastModified
+ * @param directory
+ * @return
+ */
+static bool statEntry( int dir, const char *name, qint64 *size, qint64 *lastModified, bool *directory ) {
+#ifdef STATX_BASIC_STATS
+    // kernels before 4.11 and some sandboxes reject statx outright, fstatat is used from then on
+    static std::atomic<bool> statxSupported( true );
+
+    if ( statxSupported.load( std::memory_order_relaxed )) {
+        // links are followed, broken ones are still listed
+        struct statx buffer;
+        const unsigned int mask = STATX_TYPE | STATX_SIZE | STATX_MTIME;
+        if ( ::statx( dir, name, AT_STATX_DONT_SYNC, mask, &buffer ) == 0 ||
+             ::statx( dir, name, AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, mask, &buffer ) == 0 ) {
+            *directory = S_ISDIR( buffer.stx_mode );
+            *size = *directory ? 0 : static_cast<qint64>( buffer.stx_size );
+            *lastModified = static_cast<qint64>( buffer.stx_mtime.tv_sec ) * 1000 + buffer.stx_mtime.tv_nsec / 1000000;
+            return true;
+        }
+
+        if ( errno != ENOSYS && errno != EPERM )
+            return false;
+
+        statxSupported.store( false, std::memory_order_relaxed );
+    }
+#endif
+
+    struct stat buffer;
+    if ( ::fstatat( dir, name, &buffer, 0 ) != 0 && ::fstatat( dir, name, &buffer, AT_SYMLINK_NOFOLLOW ) != 0 )
+        return false;
+
+    *directory = S_ISDIR( buffer.st_mode );
+    *size = *directory ? 0 : static_cast<qint64>( buffer.st_size );
+    *lastModified = static_cast<qint64>( buffer.st_mtim.tv_sec ) * 1000 + buffer.st_mtim.tv_nsec / 1000000;
+    return true;
+}
+#elif defined( Q_OS_WIN )
+/**
+ * @brief toMSecsSinceEpoch
+ * @param time
+ * @return
+ */
+static qint64 toMSecsSinceEpoch( const FILETIME &time ) {
+    const quint64 ticks = ( static_cast<quint64>( time.dwHighDateTime ) << 32 ) | time.dwLowDateTime;
+
+    // 100 ns ticks since 1601
+    return static_cast<qint64>( ticks / 10000 ) - 11644473600000LL;
+}
+#endif
+
+/**
+ * @brief DirectoryIndex::DirectoryIndex
+ * @param path
+ * @param parent
+ */
+DirectoryIndex::DirectoryIndex( const QString &path, QObject *parent ) : QAbstractListModel( parent ), m_rootPath( QDir( path ).absolutePath()) {
+    this->scanner.setMaxThreadCount( 1 );
+
+    IconResolver::connect( this->icons, &IconResolver::loaded, this, &DirectoryIndex::iconLoaded );
+    IconResolver::connect( this->icons, &IconResolver::prefetched, this, [ this ]() {
+        if ( this->rowCount() > 0 )
+            emit this->dataChanged( this->index( 0, 0 ), this->index( this->rowCount() - 1, 0 ), QVector<int>() << Qt::DecorationRole << IconRoles::PixmapRole );
+    } );
+    DirectoryIndex::connect( this, &DirectoryIndex::modelAboutToBeReset, this->icons, &IconResolver::clear );
+
+    // watch first, so that nothing is missed between the scan and the first change
+    this->watch();
+    this->refresh();
+}
+
+/**
+ * @brief DirectoryIndex::~DirectoryIndex
+ */
+DirectoryIndex::~DirectoryIndex() {
+    this->generation++;
+    this->unwatch();
+    this->scanner.waitForDone();
+}
+
+/**
+ * @brief DirectoryIndex::refresh rescans the directory in background
+ */
+void DirectoryIndex::refresh() {
+    if ( this->scanning ) {
+        this->rescan = true;
+        return;
+    }
+
+    const int generation = ++this->generation;
+    const QString path( this->rootPath());
+    this->scanning = true;
+
+    QtConcurrent::run( &this->scanner, [ this, generation, path ]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        const QVector<Entry> entries( DirectoryIndex::scan( path ));
+        qCDebug( indexLog ) << "DirectoryIndex: scanned" << entries.count() << "entries of" << path << "in" << timer.elapsed() << "ms";
+
+        QMetaObject::invokeMethod( this, [ this, generation, entries ]() {
+            this->scanned( generation, entries );
+        }, Qt::QueuedConnection );
+    } );
+}
+
+/**
+ * @brief DirectoryIndex::scanned replaces the rows with a finished scan
+ * @param generation
+ * @param entries
+ */
+void DirectoryIndex::scanned( int generation, const QVector<Entry> &entries ) {
+    if ( generation != this->generation )
+        return;
+
+    this->scanning = false;
+    this->beginResetModel();
+    this->entries = entries;
+    this->rows.clear();
+    for ( int y = 0; y < this->entries.count(); y++ )
+        this->rows.insert( this->entries.at( y ).name, y );
+    this->endResetModel();
+
+    // type sorting asks for every row, resolve them up front
+    QFileInfoList files;
+    QVector<IconFile> iconFiles;
+    for ( int y = 0; y < this->entries.count(); y++ ) {
+        files << this->fileInfo( this->index( y, 0 ));
+        iconFiles << this->iconFile( y );
+    }
+    MimeCache::instance()->classify( files );
+
+    this->icons->invalidate( this->rootPath());
+    if ( QSettings().value( "cache/prefetch", true ).toBool())
+        this->icons->prefetch( iconFiles );
+
+    emit this->directoryLoaded( this->rootPath());
+
+    // changes arrived while scanning, they may or may not be in this listing
+    if ( this->rescan ) {
+        this->rescan = false;
+        this->refresh();
+    }
+}
+
+/**
+ * @brief DirectoryIndex::changed updates a single entry after a change notification
+ * @param name
+ */
+void DirectoryIndex::changed( const QString &name ) {
+    if ( this->scanning ) {
+        this->rescan = true;
+        return;
+    }
+
+    Entry entry;
+    const bool exists = DirectoryIndex::stat( this->rootPath(), name, entry ) && !entry.hidden;
+    const int row = this->rows.value( name, -1 );
+
+    if ( exists && row == -1 ) {
+        const int count = this->entries.count();
+        this->beginInsertRows( QModelIndex(), count, count );
+        this->entries << entry;
+        this->rows.insert( name, count );
+        this->endInsertRows();
+    } else if ( exists ) {
+        // only the changed file is looked up again, not the whole directory
+        this->entries[row] = entry;
+        this->icons->invalidateFile( this->rootPath() + "/" + name );
+        emit this->dataChanged( this->index( row, 0 ), this->index( row, 0 ));
+    } else if ( row != -1 ) {
+        this->icons->invalidateFile( this->rootPath() + "/" + name );
+        this->beginRemoveRows( QModelIndex(), row, row );
+        this->entries.remove( row );
+        this->rows.remove( name );
+        for ( int y = row; y < this->entries.count(); y++ )
+            this->rows[this->entries.at( y ).name] = y;
+        this->endRemoveRows();
+    }
+}
+
+/**
+ * @brief DirectoryIndex::scan reads all entries of a directory, runs on a worker thread
+ * @param path
+ * @return
+ */
+QVector<DirectoryIndex::Entry> DirectoryIndex::scan( const QString &path ) {
+    QVector<Entry> entries;
+
+#if defined( Q_OS_LINUX )
+    const int dir = ::open( QFile::encodeName( path ).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+    if ( dir == -1 )
+        return entries;
+
+    // entries share the device of the directory, like FileIdentity::scan assumes
+    struct stat directory;
+    if ( ::fstat( dir, &directory ) != 0 ) {
+        ::close( dir );
+        return entries;
+    }
+
+    // one syscall returns as many names as fit, attributes are read relative to the open directory
+    alignas( Dirent64 ) char buffer[64 * 1024];
+    forever {
+        const long length = ::syscall( SYS_getdents64, dir, buffer, sizeof( buffer ));
+        if ( length <= 0 )
+            break;
+
+        for ( long offset = 0; offset < length; ) {
+            const Dirent64 *record = reinterpret_cast<const Dirent64 *>( buffer + offset );
+            offset += record->d_reclen;
+
+            if ( record->d_name[0] == '.' )
+                continue;
+
+            Entry entry;
+            entry.name = QFile::decodeName( record->d_name );
+            entry.symLink = record->d_type == DT_LNK;
+            entry.identity = FileIdentity( static_cast<quint64>( directory.st_dev ), record->d_ino );
+            if ( entry.symLink )
+                entry.symLinkTarget = QFileInfo( path + "/" + entry.name ).symLinkTarget();
+
+            if ( statEntry( dir, record->d_name, &entry.size, &entry.lastModified, &entry.directory ))
+                entries << entry;
+        }
+    }
+
+    ::close( dir );
+#elif defined( Q_OS_WIN )
+    WIN32_FIND_DATAW data;
+    const QString pattern( QDir::toNativeSeparators( path + "/*" ));
+    const HANDLE handle = FindFirstFileExW( reinterpret_cast<const wchar_t *>( pattern.utf16()), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH );
+    if ( handle == INVALID_HANDLE_VALUE )
+        return entries;
+
+    // attributes come with the listing, no per file calls needed
+    do {
+        Entry entry;
+        entry.name = QString::fromWCharArray( data.cFileName );
+        if ( entry.name == "." || entry.name == ".." || ( data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN ))
+            continue;
+
+        entry.directory = ( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0;
+        entry.symLink = ( data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT ) != 0;
+        entry.size = entry.directory ? 0 : static_cast<qint64>(( static_cast<quint64>( data.nFileSizeHigh ) << 32 ) | data.nFileSizeLow );
+        entry.lastModified = toMSecsSinceEpoch( data.ftLastWriteTime );
+        if ( entry.symLink )
+            entry.symLinkTarget = QFileInfo( path + "/" + entry.name ).symLinkTarget();
+
+        entries << entry;
+    } while ( FindNextFileW( handle, &data ));
+
+    FindClose( handle );
+#else
+    QDirIterator it( path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System );
+    while ( it.hasNext()) {
+        it.next();
+
+        Entry entry;
+        if ( DirectoryIndex::stat( path, it.fileName(), entry ) && !entry.hidden )
+            entries << entry;
+    }
+#endif
+
+    return entries;
+}
+
+/**
+ * @brief DirectoryIndex::stat reads a single entry
+ * @param path directory
+ * @param name
+ * @param entry
+ * @return false if the entry does not exist
+ */
+bool DirectoryIndex::stat( const QString &path, const QString &name, Entry &entry ) {
+    entry.name = name;
+
+#if defined( Q_OS_LINUX )
+    const QByteArray fileName( QFile::encodeName( path + "/" + name ));
+    struct stat link;
+
+    entry.hidden = name.startsWith( '.' );
+    if ( ::lstat( fileName.constData(), &link ) == 0 ) {
+        entry.symLink = S_ISLNK( link.st_mode );
+        entry.identity = FileIdentity( static_cast<quint64>( link.st_dev ), static_cast<quint64>( link.st_ino ));
+        if ( entry.symLink )
+            entry.symLinkTarget = QFileInfo( path + "/" + name ).symLinkTarget();
+    }
+
+    return statEntry( AT_FDCWD, fileName.constData(), &entry.size, &entry.lastModified, &entry.directory );
+#elif defined( Q_OS_WIN )
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    const QString fileName( QDir::toNativeSeparators( path + "/" + name ));
+    if ( !GetFileAttributesExW( reinterpret_cast<const wchar_t *>( fileName.utf16()), GetFileExInfoStandard, &data ))
+        return false;
+
+    entry.hidden = ( data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN ) != 0;
+    entry.directory = ( data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) != 0;
+    entry.symLink = ( data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT ) != 0;
+    entry.symLinkTarget = entry.symLink ? QFileInfo( path + "/" + name ).symLinkTarget() : QString();
+    entry.size = entry.directory ? 0 : static_cast<qint64>(( static_cast<quint64>( data.nFileSizeHigh ) << 32 ) | data.nFileSizeLow );
+    entry.lastModified = toMSecsSinceEpoch( data.ftLastWriteTime );
+    return true;
+#else
+    const QFileInfo info( path + "/" + name );
+    if ( !info.exists() && !info.isSymLink())
+        return false;
+
+    entry.hidden = info.isHidden();
+    entry.directory = info.isDir();
+    entry.symLink = info.isSymLink();
+    entry.symLinkTarget = entry.symLink ? info.symLinkTarget() : QString();
+    entry.size = entry.directory ? 0 : info.size();
+    entry.lastModified = info.lastModified().toMSecsSinceEpoch();
+    return true;
+#endif
+}
+
+/**
+ * @brief DirectoryIndex::watch subscribes to change notifications of the directory
+ */
+void DirectoryIndex::watch() {
+#if defined( Q_OS_LINUX )
+    this->inotify = ::inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( this->inotify == -1 )
+        return;
+
+    if ( ::inotify_add_watch( this->inotify, QFile::encodeName( this->rootPath()).constData(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                              IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR ) == -1 ) {
+        qWarning() << "DirectoryIndex: could not watch" << this->rootPath();
+        ::close( this->inotify );
+        this->inotify = -1;
+        return;
+    }
+
+    this->notifier = new QSocketNotifier( this->inotify, QSocketNotifier::Read, this );
+    QSocketNotifier::connect( this->notifier, &QSocketNotifier::activated, this, &DirectoryIndex::readChanges );
+#elif defined( Q_OS_WIN )
+    const QString path( QDir::toNativeSeparators( this->rootPath()));
+    this->directory = CreateFileW( reinterpret_cast<const wchar_t *>( path.utf16()), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr );
+    if ( this->directory == INVALID_HANDLE_VALUE ) {
+        qWarning() << "DirectoryIndex: could not watch" << this->rootPath();
+        return;
+    }
+
+    ZeroMemory( &this->overlapped, sizeof( this->overlapped ));
+    this->overlapped.hEvent = CreateEventW( nullptr, TRUE, FALSE, nullptr );
+    this->buffer.resize( 16 * 1024 );
+    this->notifier = new QWinEventNotifier( this->overlapped.hEvent, this );
+    QWinEventNotifier::connect( this->notifier, &QWinEventNotifier::activated, this, &DirectoryIndex::readChanges );
+
+    if ( !this->arm()) {
+        qWarning() << "DirectoryIndex: could not watch" << this->rootPath();
+        this->unwatch();
+    }
+#else
+    this->watcher = new QFileSystemWatcher( QStringList() << this->rootPath(), this );
+    QFileSystemWatcher::connect( this->watcher, &QFileSystemWatcher::directoryChanged, this, &DirectoryIndex::refresh );
+#endif
+}
+
+#ifdef Q_OS_WIN
+/**
+ * @brief DirectoryIndex::arm queues the next read of directory changes
+ * @return
+ */
+bool DirectoryIndex::arm() {
+    ResetEvent( this->overlapped.hEvent );
+    return ReadDirectoryChangesW( this->directory, this->buffer.data(), static_cast<DWORD>( this->buffer.count() * sizeof( DWORD )), FALSE,
+                                  FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_ATTRIBUTES,
+                                  nullptr, &this->overlapped, nullptr ) != 0;
+}
+#endif
+
+/**
+ * @brief DirectoryIndex::unwatch
+ */
+void DirectoryIndex::unwatch() {
+#if defined( Q_OS_LINUX )
+    delete this->notifier;
+    this->notifier = nullptr;
+
+    if ( this->inotify != -1 )
+        ::close( this->inotify );
+
+    this->inotify = -1;
+#elif defined( Q_OS_WIN )
+    if ( this->directory == INVALID_HANDLE_VALUE )
+        return;
+
+    // the pending read writes into the buffer until it is cancelled
+    DWORD bytes = 0;
+    CancelIoEx( this->directory, &this->overlapped );
+    GetOverlappedResult( this->directory, &this->overlapped, &bytes, TRUE );
+
+    delete this->notifier;
+    this->notifier = nullptr;
+    CloseHandle( this->overlapped.hEvent );
+    CloseHandle( this->directory );
+    this->directory = INVALID_HANDLE_VALUE;
+#else
+    delete this->watcher;
+    this->watcher = nullptr;
+#endif
+}
+
+/**
+ * @brief DirectoryIndex::readChanges collects changed names and updates their rows
+ */
+void DirectoryIndex::readChanges() {
+    QSet<QString> names;
+    bool overflow = false;
+
+#if defined( Q_OS_LINUX )
+    alignas( struct inotify_event ) char data[16 * 1024];
+    forever {
+        const ssize_t length = ::read( this->inotify, data, sizeof( data ));
+        if ( length <= 0 )
+            break;
+
+        for ( ssize_t offset = 0; offset < length; ) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>( data + offset );
+            offset += static_cast<ssize_t>( sizeof( struct inotify_event ) + event->len );
+
+            if ( event->mask & ( IN_Q_OVERFLOW | IN_DELETE_SELF | IN_MOVE_SELF ))
+                overflow = true;
+            else if ( event->len > 0 )
+                names << QFile::decodeName( event->name );
+        }
+    }
+#elif defined( Q_OS_WIN )
+    // zero bytes means the buffer overflowed, a failed read lost its changes too
+    DWORD bytes = 0;
+    overflow = !GetOverlappedResult( this->directory, &this->overlapped, &bytes, FALSE ) || bytes == 0;
+    for ( const char *data = reinterpret_cast<const char *>( this->buffer.constData()); !overflow; ) {
+        const FILE_NOTIFY_INFORMATION *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>( data );
+        names << QString::fromWCharArray( info->FileName, static_cast<int>( info->FileNameLength / sizeof( WCHAR )));
+
+        if ( info->NextEntryOffset == 0 )
+            break;
+
+        data += info->NextEntryOffset;
+    }
+
+    // the watch has to be armed again after every completed or failed read
+    if ( !this->arm())
+        qWarning() << "DirectoryIndex: stopped watching" << this->rootPath();
+#endif
+
+    if ( overflow ) {
+        this->refresh();
+        return;
+    }
+
+    for ( const QString &name : qAsConst( names ))
+        this->changed( name );
+}
+
+/**
+ * @brief DirectoryIndex::fileInfo
+ * @param index
+ * @return
+ */
+QFileInfo DirectoryIndex::fileInfo( const QModelIndex &index ) const {
+    if ( !index.isValid() || index.row() >= this->entries.count())
+        return QFileInfo();
+
+    return QFileInfo( this->rootPath() + "/" + this->entries.at( index.row()).name );
+}
+
+/**
+ * @brief DirectoryIndex::iconFile
+ * @param row
+ * @return listed metadata of the row, nothing is read from the disk
+ */
+IconFile DirectoryIndex::iconFile( int row ) const {
+    const Entry &entry( this->entries.at( row ));
+    IconFile file;
+
+    file.path = this->rootPath() + "/" + entry.name;
+    file.directory = entry.directory;
+    file.symLink = entry.symLink;
+    file.symLinkTarget = entry.symLinkTarget;
+    file.lastModified = entry.lastModified;
+    file.size = entry.size;
+    file.identity = entry.identity;
+    return file;
+}
+
+/**
+ * @brief DirectoryIndex::filePixmap
+ * @param index
+ * @return
+ */
+QPixmap DirectoryIndex::filePixmap( const QModelIndex &index ) const {
+    if ( !index.isValid() || index.row() >= this->entries.count())
+        return QPixmap();
+
+    return this->icons->pixmap( this->iconFile( index.row()));
+}
+
+/**
+ * @brief DirectoryIndex::rowCount
+ * @param parent
+ * @return
+ */
+int DirectoryIndex::rowCount( const QModelIndex &parent ) const {
+    return parent.isValid() ? 0 : this->entries.count();
+}
+
+/**
+ * @brief DirectoryIndex::data
+ * @param index
+ * @param role
+ * @return
+ */
+QVariant DirectoryIndex::data( const QModelIndex &index, int role ) const {
+    if ( !index.isValid() || index.row() >= this->entries.count())
+        return QVariant();
+
+    if ( role == Qt::DisplayRole )
+        return DesktopItem::displayName( this->entries.at( index.row()).name );
+
+    if ( role == Qt::DecorationRole )
+        return this->fileIcon( index );
+
+    if ( role == IconRoles::PixmapRole )
+        return this->filePixmap( index );
+
+    return QVariant();
+}
+
+/**
+ * @brief DirectoryIndex::flags
+ * @param index
+ * @return
+ */
+Qt::ItemFlags DirectoryIndex::flags( const QModelIndex &index ) const {
+    if ( !index.isValid())
+        return Qt::NoItemFlags;
+
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsDragEnabled | Qt::ItemNeverHasChildren;
+}
+
+/**
+ * @brief DirectoryIndex::partialItem
+ * @param row
+ * @return item without type
+ */
+DesktopItem DirectoryIndex::partialItem( int row ) const {
+    const QModelIndex index( this->index( row, 0 ));
+    if ( !index.isValid() || row >= this->entries.count())
+        return DesktopItem();
+
+    const Entry &entry( this->entries.at( row ));
+    DesktopItem item;
+    item.name = DesktopItem::displayName( entry.name );
+    item.path = this->rootPath() + "/" + entry.name;
+    item.size = entry.size;
+    item.lastModified = QDateTime::fromMSecsSinceEpoch( entry.lastModified );
+    item.flags = this->flags( index );
+    return item;
+}
+
+/**
+ * @brief DirectoryIndex::completeItem resolves the type, thread safe
+ * @param item
+ */
+void DirectoryIndex::completeItem( DesktopItem &item ) const {
+    item.type = MimeCache::instance()->name( QFileInfo( item.path ));
+}
+
+/**
+ * @brief DirectoryIndex::setScale
+ * @param scale icon size in logical pixels
+ * @param devicePixelRatio of the screen the icons are shown on
+ */
+void DirectoryIndex::setScale( int scale, qreal devicePixelRatio ) {
+    if ( !this->icons->setScale( scale, devicePixelRatio ))
+        return;
+
+    // icons are resampled from cached mip chains, no need to reset
+    if ( this->rowCount() > 0 )
+        emit this->dataChanged( this->index( 0, 0 ), this->index( this->rowCount() - 1, 0 ), QVector<int>() << Qt::DecorationRole << IconRoles::PixmapRole );
+}
+
+/**
+ * @brief DirectoryIndex::iconLoaded
+ * @param path
+ */
+void DirectoryIndex::iconLoaded( const QString &path ) {
+    const int row = this->rows.value( QFileInfo( path ).fileName(), -1 );
+    if ( row != -1 )
+        emit this->dataChanged( this->index( row, 0 ), this->index( row, 0 ), QVector<int>() << Qt::DecorationRole << IconRoles::PixmapRole );
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include "desktopitemsource.h"
+#include "iconresolver.h"
+#include <QAbstractListModel>
+#include <QFileInfo>
+#include <QHash>
+#include <QIcon>
+#include <QThreadPool>
+#include <QVector>
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#endif
+
+/*
+ * classes
+ */
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QWinEventNotifier;
+
+/**
+ * @brief The DirectoryIndex class lists a single directory level
+ *
+ * A flat alternative to QFileSystemModel: the directory is read in one
+ * pass on a worker thread (getdents64 and statx on linux, large fetch
+ * FindFirstFileEx on windows, QDirIterator elsewhere) and afterwards kept
+ * up to date per entry from inotify or ReadDirectoryChangesW. Rows are in
+ * directory order, hidden entries are skipped like QFileSystemModel does.
+ */
+class DirectoryIndex : public QAbstractListModel, public DesktopItemSource {
+    Q_OBJECT
+
+public:
+    explicit DirectoryIndex( const QString &path, QObject *parent = nullptr );
+    ~DirectoryIndex() override;
+    QString rootPath() const { return this->m_rootPath; }
+    QFileInfo fileInfo( const QModelIndex &index ) const;
+    QPixmap filePixmap( const QModelIndex &index ) const;
+    QIcon fileIcon( const QModelIndex &index ) const { return QIcon( this->filePixmap( index )); }
+    int rowCount( const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
+    Qt::ItemFlags flags( const QModelIndex &index ) const override;
+    QAbstractItemModel *model() override { return this; }
+    DesktopItem partialItem( int row ) const override;
+    void completeItem( DesktopItem &item ) const override;
+
+public slots:
+    void setScale( int scale, qreal devicePixelRatio = 1.0 ) override;
+    void refresh();
+
+signals:
+    void directoryLoaded( const QString &path );
+
+private slots:
+    void iconLoaded( const QString &path );
+
+private:
+    struct Entry {
+        QString name;
+        qint64 size = 0;
+        qint64 lastModified = 0;
+        bool directory = false;
+        bool hidden = false;
+        bool symLink = false;
+        QString symLinkTarget;
+        FileIdentity identity;
+    };
+
+    static QVector<Entry> scan( const QString &path );
+    static bool stat( const QString &path, const QString &name, Entry &entry );
+    IconFile iconFile( int row ) const;
+    void scanned( int generation, const QVector<Entry> &entries );
+    void changed( const QString &name );
+    void watch();
+    void unwatch();
+    void readChanges();
+
+    QString m_rootPath;
+    QVector<Entry> entries;
+    QHash<QString, int> rows;
+    IconResolver *icons = new IconResolver( this );
+    QThreadPool scanner;
+    int generation = 0;
+    bool scanning = false;
+    bool rescan = false;
+#if defined( Q_OS_LINUX )
+    int inotify = -1;
+    QSocketNotifier *notifier = nullptr;
+#elif defined( Q_OS_WIN )
+    bool arm();
+    HANDLE directory = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped;
+    QVector<DWORD> buffer;
+    QWinEventNotifier *notifier = nullptr;
+#else
+    QFileSystemWatcher *watcher = nullptr;
+#endif
+};
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "fileidentity.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QVector>
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief FileIdentity::query
+ * @param path
+ * @return
+ */
+FileIdentity FileIdentity::query( const QString &path ) {
+#ifdef Q_OS_WIN
+    const HANDLE handle = CreateFileW( reinterpret_cast<const wchar_t *>( QDir::toNativeSeparators( path ).utf16()), 0,
+                                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                       FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, nullptr );
+    if ( handle == INVALID_HANDLE_VALUE )
+        return FileIdentity();
+
+    BY_HANDLE_FILE_INFORMATION info;
+    const bool ok = GetFileInformationByHandle( handle, &info );
+    CloseHandle( handle );
+
+    if ( !ok )
+        return FileIdentity();
+
+    return FileIdentity( info.dwVolumeSerialNumber, ( static_cast<quint64>( info.nFileIndexHigh ) << 32 ) | info.nFileIndexLow );
+#else
+    struct stat info;
+    if ( ::lstat( QFile::encodeName( path ).constData(), &info ) != 0 )
+        return FileIdentity();
+
+    return FileIdentity( static_cast<quint64>( info.st_dev ), static_cast<quint64>( info.st_ino ));
+#endif
+}
+
+/**
+ * @brief FileIdentity::scan
+ * @param directory
+ * @return identities of all entries, keyed by absolute path
+ */
+QHash<QString, FileIdentity> FileIdentity::scan( const QString &directory ) {
+    QHash<QString, FileIdentity> identities;
+    const QString prefix( QDir( directory ).absolutePath() + "/" );
+
+#ifdef Q_OS_WIN
+    const HANDLE handle = CreateFileW( reinterpret_cast<const wchar_t *>( QDir::toNativeSeparators( directory ).utf16()), FILE_LIST_DIRECTORY,
+                                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                       FILE_FLAG_BACKUP_SEMANTICS, nullptr );
+    if ( handle == INVALID_HANDLE_VALUE )
+        return identities;
+
+    BY_HANDLE_FILE_INFORMATION directoryInfo;
+    if ( !GetFileInformationByHandle( handle, &directoryInfo )) {
+        CloseHandle( handle );
+        return identities;
+    }
+
+    // entries must be 8 byte aligned
+    QVector<quint64> buffer( 8192 );
+    FILE_INFO_BY_HANDLE_CLASS infoClass = FileIdBothDirectoryRestartInfo;
+    while ( GetFileInformationByHandleEx( handle, infoClass, buffer.data(), static_cast<DWORD>( buffer.size() * sizeof( quint64 )))) {
+        const uchar *entry = reinterpret_cast<const uchar *>( buffer.constData());
+        infoClass = FileIdBothDirectoryInfo;
+
+        forever {
+            const FILE_ID_BOTH_DIR_INFO *info = reinterpret_cast<const FILE_ID_BOTH_DIR_INFO *>( entry );
+            const QString name( QString::fromWCharArray( info->FileName, static_cast<int>( info->FileNameLength / sizeof( wchar_t ))));
+
+            if ( name != "." && name != ".." )
+                identities.insert( prefix + name, FileIdentity( directoryInfo.dwVolumeSerialNumber, static_cast<quint64>( info->FileId.QuadPart )));
+
+            if ( info->NextEntryOffset == 0 )
+                break;
+
+            entry += info->NextEntryOffset;
+        }
+    }
+
+    CloseHandle( handle );
+#else
+    // all entries share the device of the directory (mount points aside)
+    struct stat info;
+    if ( ::stat( QFile::encodeName( directory ).constData(), &info ) != 0 )
+        return identities;
+
+    DIR *handle = ::opendir( QFile::encodeName( directory ).constData());
+    if ( handle == nullptr )
+        return identities;
+
+    while ( const dirent *entry = ::readdir( handle )) {
+        const QString name( QFile::decodeName( entry->d_name ));
+
+        if ( name != "." && name != ".." )
+            identities.insert( prefix + name, FileIdentity( static_cast<quint64>( info.st_dev ), static_cast<quint64>( entry->d_ino )));
+    }
+
+    ::closedir( handle );
+#endif
+
+    return identities;
+}
+
+/**
+ * @brief FileIdentity::validator summarizes file contents from already cached metadata
+ * @param info
+ * @return
+ */
+quint64 FileIdentity::validator( const QFileInfo &info ) {
+    return FileIdentity::validator( info.lastModified().toMSecsSinceEpoch(), info.size(), info.isSymLink() ? info.symLinkTarget() : QString());
+}
+
+/**
+ * @brief FileIdentity::validator
+ * @param lastModified milliseconds since epoch
+ * @param size
+ * @param symLinkTarget empty unless the file is a link
+ * @return
+ */
+quint64 FileIdentity::validator( qint64 lastModified, qint64 size, const QString &symLinkTarget ) {
+    quint64 hash = static_cast<quint64>( lastModified );
+
+    hash = hash * 1099511628211ULL ^ static_cast<quint64>( size );
+    if ( !symLinkTarget.isEmpty())
+        hash = hash * 1099511628211ULL ^ qHash( symLinkTarget );
+
+    // zero means "not validated"
+    return hash != 0 ? hash : 1;
+}
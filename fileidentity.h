@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QFileInfo>
+#include <QHash>
+
+/**
+ * @brief The FileIdentity class identifies a file independently of its name
+ *
+ * Device and inode on unix, volume serial and file index on windows.
+ * A whole directory is read in one pass (readdir or a single
+ * FileIdBothDirectoryInfo query) so that listing does not cost one
+ * handle or stat per file.
+ */
+class FileIdentity {
+public:
+    FileIdentity() = default;
+    FileIdentity( quint64 volume, quint64 file ) : m_volume( volume ), m_file( file ) {}
+    bool isValid() const { return this->m_file != 0; }
+    quint64 volume() const { return this->m_volume; }
+    quint64 file() const { return this->m_file; }
+    QString toString() const { return QString( "%1_%2" ).arg( this->m_volume, 0, 16 ).arg( this->m_file, 0, 16 ); }
+
+    static FileIdentity query( const QString &path );
+    static QHash<QString, FileIdentity> scan( const QString &directory );
+    static quint64 validator( const QFileInfo &info );
+    static quint64 validator( qint64 lastModified, qint64 size, const QString &symLinkTarget = QString());
+
+private:
+    quint64 m_volume = 0;
+    quint64 m_file = 0;
+};
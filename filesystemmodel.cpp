@@ -20,50 +20,38 @@
  * includes
  */
 #include "filesystemmodel.h"
-#include <QDebug>
-#include <QMimeDatabase>
-#ifdef Q_OS_WIN
-#include <QtWin>
-#include <Windows.h>
-#include <CommCtrl.h>
-#include <commoncontrols.h>
-#include <shellapi.h>
-#include <WinUser.h>
-#endif
-#include <QOperatingSystemVersion>
+#include "iconcache.h"
+#include "mimecache.h"
+#include <QDir>
+#include <QSettings>
 
 /**
  * @brief FileSystemModel::FileSystemModel
  * @param parent
  */
 FileSystemModel::FileSystemModel( const QString &path, QObject *parent ) : QFileSystemModel( parent ) {
+    IconResolver::connect( this->icons, &IconResolver::loaded, this, &FileSystemModel::iconLoaded );
+    IconResolver::connect( this->icons, &IconResolver::prefetched, this, [ this ]() {
+        if ( this->rowCount( QModelIndex()) > 0 )
+            emit this->dataChanged( this->index( 0, 0 ), this->index( this->rowCount( QModelIndex()) - 1, 0 ), QVector<int>() << Qt::DecorationRole << IconRoles::PixmapRole );
+    } );
+    FileSystemModel::connect( this, &FileSystemModel::modelAboutToBeReset, this->icons, &IconResolver::clear );
+    FileSystemModel::connect( this, &FileSystemModel::directoryLoaded, this, [ this ]( const QString &path ) {
+        this->icons->invalidate( path );
+
+        if ( QDir( path ) != QDir( this->rootPath()))
+            return;
+
+        // type sorting asks for every row, resolve them up front
+        QFileInfoList files;
+        for ( int y = 0; y < this->rowCount( QModelIndex()); y++ )
+            files << this->fileInfo( this->index( y, 0 ));
+        MimeCache::instance()->classify( files );
+
+        if ( QSettings().value( "cache/prefetch", true ).toBool())
+            this->icons->prefetch( files );
+    } );
     this->setRootPath( path );
-
-    const QDir dir( "cache/" );
-    if ( !dir.exists())
-        dir.mkpath( "." );
-}
-
-/**
- * @brief FileSystemModel::fileIcon
- * @param index
- * @return
- */
-QIcon FileSystemModel::fileIcon( const QModelIndex &index ) const {
-    const QFileInfo info( this->fileInfo( index ));
-    const auto identifier( qMakePair( info.absoluteFilePath(), info.isSymLink() ? info.symLinkTarget().size() : info.size()));
-    if ( this->iconCache.contains( identifier ))
-        return this->iconCache[identifier];
-
-    QPixmap pixmap;
-    if ( pixmap.load( QString( "cache/%1_%2_%3.png" ).arg( QString( QByteArray( info.absoluteFilePath().toUtf8().constData()).toBase64())).arg( info.size()).arg( QString::number( this->scale()))))
-        return QIcon( pixmap );
-
-    const QIcon icon( FileSystemModel::getIcon( info ));
-    if ( icon.isNull())
-        return QFileSystemModel::fileIcon( index );
-
-    return icon;
 }
 
 /**
@@ -78,167 +66,13 @@ QModelIndex FileSystemModel::index( int row, int column, const QModelIndex & ) c
 }
 
 /**
- * @brief FileSystemModel::getIconPixmap
- * @param info
- * @param size
- * @return
- */
-QPixmap FileSystemModel::getIconPixmap( const QFileInfo &info, int scale ) {
-    SHFILEINFO fileInfo;
-    QPixmap pixmap, cache;
-    QImage image;
-    int flags = SHGFI_ICON | SHGFI_SYSICONINDEX | SHGFI_LARGEICON;
-    int y, k;
-    bool ok = false;
-
-    memset( &fileInfo, 0, sizeof( SHFILEINFO ));
-
-    if ( !info.isDir())
-        flags |= SHGFI_USEFILEATTRIBUTES;
-
-    // win32 icon cache
-    const QMimeDatabase db;
-    const QMimeType mime( db.mimeTypeForFile( info.absoluteFilePath(), QMimeDatabase::MatchContent ));
-    const int hrFileInfo = static_cast<const int>( SHGetFileInfo( reinterpret_cast<const wchar_t *>( QDir::toNativeSeparators( info.absoluteFilePath()).utf16()), 0, &fileInfo, sizeof( SHFILEINFO ), static_cast<UINT>( flags )));
-
-    // for some reason this always fails on msvc
-#ifndef Q_CC_MSVC
-    if ( static_cast<const int>( hrFileInfo ) >= 0 )
-#else
-    Q_UNUSED( hrFileInfo )
-#endif
-    {
-        if ( QOperatingSystemVersion::current() >= QOperatingSystemVersion::Windows7 && fileInfo.hIcon ) {
-            /**
-             * @brief pixmapFromImageList
-             * @param index
-             * @param pixmap
-             */
-            auto pixmapFromImageList = [ fileInfo ]( int index, QPixmap &pixmap ) {
-                IImageList *imageList = nullptr;
-                HICON hIcon = nullptr;
-
-                if ( static_cast<int>( SHGetImageList( index, IID_PPV_ARGS( &imageList ))) >= 0 ) {
-                    if ( static_cast<int>( imageList->GetIcon( fileInfo.iIcon, ILD_TRANSPARENT, &hIcon )) >=0 ) {
-                        pixmap = QtWin::fromHICON( hIcon );
-                        DestroyIcon( hIcon );
-                        imageList->Release();
-                    }
-                }
-            };
-
-            // first try to get the jumbo icon
-            pixmapFromImageList( 0x4, pixmap );
-
-            // test if most of the image is blank
-            // (invalid jumbo with 48x48 on top left)
-            if ( pixmap.width() >= 64 && pixmap.height() >= 64 ) {
-                image = pixmap.toImage();
-                for ( y = 64; y < pixmap.width(); y++ ) {
-                    for ( k = 64; k < pixmap.height(); k++ ) {
-                        if ( image.pixelColor( y, k ).alphaF() > 0.0 )
-                            ok = true;
-                    }
-                }
-            }
-
-            // check if icon is really a small, but centered one
-            if ( ok ) {
-                enum Sides { Top = 0, Bottom, Right, Left };
-                auto checkSide = [ image ]( Sides side, int scale ) {
-                    if ( image.width() != 256 || image.height() != 256 )
-                        return false;
-
-                    if ( scale <= 8 || scale >= 128 )
-                        return false;
-
-                    int hOffset = 0, vOffset = 0;
-                    int hBound = image.width();
-                    int vBound = image.height();
-
-                    switch ( side ) {
-                    case Top:
-                        vBound = scale;
-                        break;
-
-                    case Bottom:
-                        vOffset = 256 - scale;
-                        break;
-
-                    case Left:
-                        hBound = scale;
-                        break;
-
-                    case Right:
-                        hOffset = 256 - scale;
-                        break;
-                    }
-
-                    bool blank = true;
-                    for ( int x = hOffset; x < hBound; x++ ) {
-                        for ( int y = vOffset; y < vBound; y++ ) {
-                            if ( image.pixelColor( x, y ).alphaF() > 0.0 )
-                                blank = false;
-                        }
-                    }
-                    return blank;
-                };
-
-                const int cropScale = 64;
-                if ( checkSide( Top, cropScale ) && checkSide( Bottom, cropScale ) && checkSide( Left, cropScale ) && checkSide( Right, cropScale ))
-                    ok = false;
-            }
-
-            // then try to get the large icon
-            if ( pixmap.isNull() || !ok )
-                pixmapFromImageList( 0x2, pixmap );
-        }
-
-        // if everything fails, get icon the old way
-        if ( pixmap.isNull() && fileInfo.hIcon != nullptr ) {
-            pixmap = QtWin::fromHICON( fileInfo.hIcon );
-            DestroyIcon( fileInfo.hIcon );
-        }
-    }
-
-    /**
-     * @brief downscale
-     * @param pixmap
-     * @param scale
-     * @return
-     */
-    auto downscale = []( const QPixmap &pixmap, int scale ) {
-        QPixmap downScaled( pixmap );
-
-        if ( pixmap.isNull() || scale <= 0 )
-            return QPixmap();
-
-        if ( downScaled.width() >= scale * 2 )
-            downScaled = downScaled.scaled( scale * 2, scale * 2, Qt::IgnoreAspectRatio, Qt::FastTransformation );
-
-        return downScaled.scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
-    };
-
-    pixmap = downscale( pixmap, scale );
-    return pixmap;
-}
-
-/**
- * @brief FileSystemModel::getIcon
- * @param info
- * @return
+ * @brief FileSystemModel::iconLoaded
+ * @param path
  */
-QIcon FileSystemModel::getIcon( const QFileInfo &info ) const {
-    const QPixmap pixmap( FileSystemModel::getIconPixmap( info, this->scale()));
-    const QIcon icon( pixmap );
-    this->iconCache[qMakePair( info.absoluteFilePath(), info.isSymLink() ? info.symLinkTarget().size() : info.size())] = icon;
-
-    if ( !icon.isNull()) {
-        qDebug() << "FileSystemModel: write cache";
-        pixmap.save( QString( "cache/%1_%2_%3.png" ).arg( QString( QByteArray( info.absoluteFilePath().toUtf8().constData()).toBase64())).arg( info.size()).arg( QString::number( this->scale())));
-    }
-
-    return icon;
+void FileSystemModel::iconLoaded( const QString &path ) {
+    const QModelIndex index( QFileSystemModel::index( path ));
+    if ( index.isValid())
+        emit this->dataChanged( index, index, QVector<int>() << Qt::DecorationRole << IconRoles::PixmapRole );
 }
 
 /**
@@ -257,32 +91,62 @@ int FileSystemModel::rowCount( const QModelIndex & ) const {
  */
 QVariant FileSystemModel::data( const QModelIndex &index, int role ) const {
     if ( role == Qt::DisplayRole ) {
-        const QString fileName( QFileSystemModel::data( index, Qt::DisplayRole ).toString());
-        return ( fileName.endsWith( ".lnk" )) ? QString( fileName ).left( fileName.length() - 4 ) : fileName;
+        return DesktopItem::displayName( QFileSystemModel::data( index, Qt::DisplayRole ).toString());
     }
 
     if ( role == Qt::DecorationRole )
         return this->fileIcon( index );
 
+    if ( role == IconRoles::PixmapRole )
+        return this->filePixmap( index );
+
     return QFileSystemModel::data( index, role );
 }
 
+/**
+ * @brief FileSystemModel::partialItem
+ * @param row
+ * @return item without type
+ */
+DesktopItem FileSystemModel::partialItem( int row ) const {
+    const QModelIndex index( this->index( row, 0 ));
+
+    DesktopItem item;
+    item.name = DesktopItem::displayName( this->fileName( index ));
+    item.path = this->filePath( index );
+    item.size = this->size( index );
+    item.lastModified = this->lastModified( index );
+    item.flags = this->flags( index );
+    return item;
+}
+
+/**
+ * @brief FileSystemModel::completeItem resolves the type, thread safe
+ * @param item
+ */
+void FileSystemModel::completeItem( DesktopItem &item ) const {
+    item.type = MimeCache::instance()->name( QFileInfo( item.path ));
+}
+
 /**
  * @brief FileSystemModel::mimeTypeName
  * @param index
  * @return
  */
 QString FileSystemModel::mimeTypeName( const QModelIndex &index ) const {
-    return QMimeDatabase().mimeTypeForFile( this->filePath( index )/*, QMimeDatabase::MatchContent*/ ).name();
+    return MimeCache::instance()->name( this->fileInfo( index ));
 }
 
 /**
  * @brief FileSystemModel::setScale
- * @param scale
+ * @param scale icon size in logical pixels
+ * @param devicePixelRatio of the screen the icons are shown on
  */
-void FileSystemModel::setScale( int scale ) {
-    this->beginResetModel();
-    this->iconCache.clear();
-    this->m_scale = scale;
-    this->endResetModel();
+void FileSystemModel::setScale( int scale, qreal devicePixelRatio ) {
+    if ( !this->icons->setScale( scale, devicePixelRatio ))
+        return;
+
+    // icons are resampled from cached mip chains, no need to reset
+    if ( this->rowCount( QModelIndex()) > 0 )
+        emit this->dataChanged( this->index( 0, 0 ), this->index( this->rowCount( QModelIndex()) - 1, 0 ), QVector<int>() << Qt::DecorationRole << IconRoles::PixmapRole );
 }
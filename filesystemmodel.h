@@ -24,30 +24,43 @@
 #include <QFileSystemModel>
 #include <QFileInfo>
 #include <QIcon>
+#include "desktopitemsource.h"
+#include "iconresolver.h"
 
 /**
  * @brief The FileSystemModel class
  */
-class FileSystemModel : public QFileSystemModel {
+class FileSystemModel : public QFileSystemModel, public DesktopItemSource {
     Q_OBJECT
 
 public:
     explicit FileSystemModel( const QString &path, QObject *parent = nullptr );
     ~FileSystemModel() override = default;
-    QIcon fileIcon( const QModelIndex & ) const;
+    QIcon fileIcon( const QModelIndex &index ) const { return QIcon( this->filePixmap( index )); }
+    QPixmap filePixmap( const QModelIndex &index ) const { return this->icons->pixmap( this->fileInfo( index )); }
     QModelIndex index( int row, int column, const QModelIndex &parent = QModelIndex()) const override;
-    int scale() const { return this->m_scale; }
-    static QPixmap getIconPixmap( const QFileInfo &info, int size = 48 );
-    QIcon getIcon( const QFileInfo &info ) const;
+    int scale() const { return this->icons->scale(); }
+    qreal devicePixelRatio() const { return this->icons->devicePixelRatio(); }
+    int pixelSize() const { return this->icons->pixelSize(); }
     int rowCount( const QModelIndex & ) const override;
     int columnCount( const QModelIndex & ) const override { return 1; }
+    // SortModel owns ordering, this turns off QFileSystemModel's own delayed sort
+    void sort( int, Qt::SortOrder ) override {}
     QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
     QString mimeTypeName( const QModelIndex &index ) const;
+    quint64 iconClassHits() const { return this->icons->hits(); }
+    quint64 iconClassMisses() const { return this->icons->misses(); }
+    QAbstractItemModel *model() override { return this; }
+    QModelIndex rootIndex() const override { return QFileSystemModel::index( this->rootPath()); }
+    DesktopItem partialItem( int row ) const override;
+    void completeItem( DesktopItem &item ) const override;
 
 public slots:
-    void setScale( int scale );
+    void setScale( int scale, qreal devicePixelRatio = 1.0 ) override;
+
+private slots:
+    void iconLoaded( const QString &path );
 
 private:
-    mutable QMap<QPair<QString,qint64>,QIcon> iconCache;
-    int m_scale = 48; // TODO: copy from ListView
+    IconResolver *icons = new IconResolver( this );
 };
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "iconcache.h"
+#include <QSettings>
+
+/**
+ * @brief IconCache::instance
+ * @return
+ */
+IconCache *IconCache::instance() {
+    static IconCache cache( QSettings().value( "cache/memoryBudget", 64 * 1024 * 1024 ).toLongLong());
+    return &cache;
+}
+
+/**
+ * @brief IconCache::fit makes a pixmap exactly size device pixels wide and tags it with ratio
+ * @param pixmap
+ * @param size in device pixels
+ * @param ratio
+ * @return
+ */
+QPixmap IconCache::fit( const QPixmap &pixmap, int size, qreal ratio ) {
+    if ( pixmap.isNull())
+        return QPixmap();
+
+    QPixmap exact( pixmap.width() == size && pixmap.height() == size ? pixmap : pixmap.scaled( size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation ));
+    exact.setDevicePixelRatio( ratio );
+    return exact;
+}
+
+/**
+ * @brief IconCache::IconCache
+ * @param budget in bytes
+ */
+IconCache::IconCache( qint64 budget ) : m_budget( budget ) {
+}
+
+/**
+ * @brief IconCache::pixmap returns a cached pixmap and marks it as recently used
+ * @param key
+ * @return
+ */
+QPixmap IconCache::pixmap( const QString &key ) {
+    const auto it = this->index.constFind( key );
+    if ( it == this->index.constEnd()) {
+        this->m_misses++;
+        return QPixmap();
+    }
+
+    this->m_hits++;
+    this->entries.splice( this->entries.begin(), this->entries, it.value());
+    return it.value()->pixmap;
+}
+
+/**
+ * @brief IconCache::insert
+ * @param key
+ * @param pixmap
+ */
+void IconCache::insert( const QString &key, const QPixmap &pixmap ) {
+    this->remove( key );
+
+    const qint64 cost = IconCache::cost( pixmap );
+    if ( pixmap.isNull() || cost > this->budget())
+        return;
+
+    this->entries.push_front( Entry { key, pixmap, cost } );
+    this->index.insert( key, this->entries.begin());
+    this->m_residentBytes += cost;
+    this->trim();
+}
+
+/**
+ * @brief IconCache::remove
+ * @param key
+ */
+void IconCache::remove( const QString &key ) {
+    const auto it = this->index.find( key );
+    if ( it == this->index.end())
+        return;
+
+    this->m_residentBytes -= it.value()->cost;
+    this->entries.erase( it.value());
+    this->index.erase( it );
+}
+
+/**
+ * @brief IconCache::clear
+ */
+void IconCache::clear() {
+    this->entries.clear();
+    this->index.clear();
+    this->m_residentBytes = 0;
+}
+
+/**
+ * @brief IconCache::setBudget
+ * @param budget in bytes
+ */
+void IconCache::setBudget( qint64 budget ) {
+    this->m_budget = budget;
+    this->trim();
+}
+
+/**
+ * @brief IconCache::trim evicts least recently used entries until within budget
+ */
+void IconCache::trim() {
+    while ( this->m_residentBytes > this->budget() && !this->entries.empty()) {
+        const Entry &entry = this->entries.back();
+        this->m_residentBytes -= entry.cost;
+        this->index.remove( entry.key );
+        this->entries.pop_back();
+        this->m_evictions++;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QHash>
+#include <QPixmap>
+#include <list>
+
+/**
+ * @brief The IconRoles namespace
+ */
+namespace IconRoles {
+/*
+ * ready to blit pixmap at the view's icon size and device pixel ratio
+ * kept clear of QFileSystemModel::Roles (Qt::UserRole + 1 to + 3), which FileSystemModel still serves
+ */
+[[maybe_unused]] constexpr static const int PixmapRole = Qt::UserRole + 100;
+};
+
+/**
+ * @brief The IconCache class is the in-memory icon tier shared by all models
+ *
+ * Entries are costed by pixmap bytes and evicted least recently used
+ * first once the byte budget is exceeded. GUI thread only.
+ */
+class IconCache {
+    Q_DISABLE_COPY( IconCache )
+
+public:
+    static IconCache *instance();
+    static QPixmap fit( const QPixmap &pixmap, int size, qreal ratio );
+    explicit IconCache( qint64 budget );
+    QPixmap pixmap( const QString &key );
+    bool contains( const QString &key ) const { return this->index.contains( key ); }
+    void insert( const QString &key, const QPixmap &pixmap );
+    void remove( const QString &key );
+    void clear();
+    qint64 budget() const { return this->m_budget; }
+    void setBudget( qint64 budget );
+    quint64 hits() const { return this->m_hits; }
+    quint64 misses() const { return this->m_misses; }
+    quint64 evictions() const { return this->m_evictions; }
+    qint64 residentBytes() const { return this->m_residentBytes; }
+    int count() const { return this->index.count(); }
+
+private:
+    struct Entry {
+        QString key;
+        QPixmap pixmap;
+        qint64 cost;
+    };
+    using Iterator = std::list<Entry>::iterator;
+
+    static qint64 cost( const QPixmap &pixmap ) { return static_cast<qint64>( pixmap.width()) * pixmap.height() * qMax( pixmap.depth(), 8 ) / 8; }
+    void trim();
+    std::list<Entry> entries;
+    QHash<QString, Iterator> index;
+    qint64 m_budget;
+    qint64 m_residentBytes = 0;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+    quint64 m_evictions = 0;
+};
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "iconclassifier.h"
+#include "mimecache.h"
+
+/**
+ * @brief IconFile::fromInfo
+ * @param info
+ * @return
+ */
+IconFile IconFile::fromInfo( const QFileInfo &info ) {
+    IconFile file;
+
+    file.path = info.absoluteFilePath();
+    file.directory = info.isDir();
+    file.symLink = info.isSymLink();
+
+    // read once from the cached info, on Windows every .lnk shortcut is a link resolved through IShellLink
+    if ( file.symLink )
+        file.symLinkTarget = info.symLinkTarget();
+
+    file.lastModified = info.lastModified().toMSecsSinceEpoch();
+    file.size = info.size();
+    return file;
+}
+
+/**
+ * @brief IconClassifier::kind
+ * @param file
+ * @return
+ */
+IconClassifier::Kind IconClassifier::kind( const IconFile &file ) const {
+    static const QSet<QString> perFile( QSet<QString>() << "exe" << "lnk" << "ico" << "cur" << "ani" << "url"
+                                        << "desktop" << "scr" << "cpl" << "msc" << "appref-ms" );
+
+    // folders can be customized through desktop.ini
+    if ( file.directory ) {
+        const QString &path( file.path );
+        const auto it = this->folders.constFind( path );
+        if ( it != this->folders.constEnd())
+            return it.value();
+
+        const Kind kind = QFileInfo::exists( path + "/desktop.ini" ) ? File : Type;
+        this->folders[path] = kind;
+        return kind;
+    }
+
+    if ( file.symLink )
+        return File;
+
+    // only the name is looked at, nothing is read from the disk
+    return perFile.contains( QFileInfo( file.path ).suffix().toLower()) ? File : Type;
+}
+
+/**
+ * @brief IconClassifier::key
+ * @param file
+ * @return
+ */
+QString IconClassifier::key( const IconFile &file ) const {
+    if ( this->kind( file ) == File ) {
+        const FileIdentity identity( file.identity.isValid() ? file.identity : this->identity( file.path ));
+        if ( identity.isValid())
+            return QString( "file_%1" ).arg( identity.toString());
+
+        return QString( "path_%1" ).arg( QString( file.path.toUtf8().toBase64()));
+    }
+
+    if ( file.directory )
+        return "dir";
+
+    // extensionless files (executables, scripts, READMEs) would otherwise all share one icon
+    const QString suffix( QFileInfo( file.path ).suffix().toLower());
+    if ( suffix.isEmpty())
+        return QString( "mime_%1" ).arg( this->mimeType( file ));
+
+    return QString( "type_%1" ).arg( suffix );
+}
+
+/**
+ * @brief IconClassifier::mimeType
+ * @param file
+ * @return type of the file by its contents, remembered until the file changes
+ */
+QString IconClassifier::mimeType( const IconFile &file ) const {
+    const quint64 validator = FileIdentity::validator( file.lastModified, file.size, file.symLinkTarget );
+    const auto it = this->mimeTypes.constFind( file.path );
+    if ( it != this->mimeTypes.constEnd() && it->first == validator )
+        return it->second;
+
+    const QString name( MimeCache::instance()->name( QFileInfo( file.path ), MimeCache::Content ));
+    this->mimeTypes.insert( file.path, qMakePair( validator, name ));
+    return name;
+}
+
+/**
+ * @brief IconClassifier::validator
+ * @param file
+ * @return zero for icons shared by type
+ */
+quint64 IconClassifier::validator( const IconFile &file ) const {
+    if ( this->kind( file ) != File )
+        return 0;
+
+    return FileIdentity::validator( file.lastModified, file.size, file.symLinkTarget );
+}
+
+/**
+ * @brief IconClassifier::identity
+ * @param path absolute file path
+ * @return
+ */
+FileIdentity IconClassifier::identity( const QString &path ) const {
+    // read the whole directory the first time one of its files is seen
+    const QString directory( QFileInfo( path ).absolutePath());
+    if ( !this->scanned.contains( directory )) {
+        this->scanned << directory;
+
+        const QHash<QString, FileIdentity> entries( FileIdentity::scan( directory ));
+        for ( auto entry = entries.constBegin(); entry != entries.constEnd(); ++entry )
+            this->identities.insert( entry.key(), entry.value());
+    }
+
+    auto it = this->identities.constFind( path );
+    if ( it == this->identities.constEnd())
+        it = this->identities.insert( path, FileIdentity::query( path ));
+
+    return it.value();
+}
+
+/**
+ * @brief IconClassifier::invalidateFile forgets a single file, the rest of its directory stays scanned
+ * @param path absolute file path
+ */
+void IconClassifier::invalidateFile( const QString &path ) {
+    this->folders.remove( path );
+    this->mimeTypes.remove( path );
+    this->identities.remove( path );
+}
+
+/**
+ * @brief IconClassifier::clear
+ */
+void IconClassifier::clear() {
+    this->folders.clear();
+    this->mimeTypes.clear();
+    this->identities.clear();
+    this->scanned.clear();
+}
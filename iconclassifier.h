@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include "fileidentity.h"
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+
+/**
+ * @brief The IconFile struct is what icon lookup needs to know about a file
+ *
+ * Listings that already hold this metadata pass it in directly, so that
+ * painting an icon does not stat the file again.
+ */
+struct IconFile {
+    QString path;
+    bool directory = false;
+    bool symLink = false;
+    QString symLinkTarget;
+    qint64 lastModified = 0;
+    qint64 size = 0;
+    FileIdentity identity;
+
+    static IconFile fromInfo( const QFileInfo &info );
+};
+
+/**
+ * @brief The IconClassifier class decides how widely an icon can be shared
+ *
+ * Most files show the icon of their type, so one extraction serves every
+ * file with the same extension (or every plain directory). Files without
+ * an extension are grouped by their MIME type instead. Executables,
+ * shortcuts, icon files and customized folders carry their own icon and
+ * get a per-file key instead, built from the file identity so that it
+ * survives renames; validator() then tells whether contents changed.
+ * Identities are read a whole directory at a time and, like the
+ * desktop.ini probe for folders, remembered until clear() is called.
+ */
+class IconClassifier {
+public:
+    enum Kind {
+        Type,
+        File
+    };
+
+    Kind kind( const IconFile &file ) const;
+    QString key( const IconFile &file ) const;
+    quint64 validator( const IconFile &file ) const;
+    void clear();
+    void invalidate( const QString &directory ) { this->scanned.remove( QFileInfo( directory ).absoluteFilePath()); }
+    void invalidateFile( const QString &path );
+    void hit() { this->m_hits++; }
+    void miss() { this->m_misses++; }
+    quint64 hits() const { return this->m_hits; }
+    quint64 misses() const { return this->m_misses; }
+
+private:
+    FileIdentity identity( const QString &path ) const;
+    QString mimeType( const IconFile &file ) const;
+    mutable QHash<QString, Kind> folders;
+    mutable QHash<QString, QPair<quint64, QString>> mimeTypes;
+    mutable QHash<QString, FileIdentity> identities;
+    mutable QSet<QString> scanned;
+    quint64 m_hits = 0;
+    quint64 m_misses = 0;
+};
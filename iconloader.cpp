@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "iconloader.h"
+#include <QtConcurrent>
+#ifdef Q_OS_WIN
+#include <objbase.h>
+#endif
+
+/**
+ * @brief IconLoader::IconLoader
+ * @param parent
+ */
+IconLoader::IconLoader( QObject *parent ) : QObject( parent ) {
+    // shell calls do not scale well past a handful of threads
+    this->pool.setMaxThreadCount( qBound( 1, QThread::idealThreadCount() - 1, 4 ));
+}
+
+/**
+ * @brief IconLoader::~IconLoader
+ */
+IconLoader::~IconLoader() {
+    this->cancel();
+    this->pool.waitForDone();
+}
+
+/**
+ * @brief IconLoader::request
+ * @param key
+ * @param job
+ * @return false if the key is already queued
+ */
+bool IconLoader::request( const QString &key, const Job &job ) {
+    if ( this->pending.contains( key ))
+        return false;
+
+    this->pending << key;
+
+    const int generation = this->generation.loadAcquire();
+    QtConcurrent::run( &this->pool, [ this, key, job, generation ]() {
+        // request was cancelled before it got a chance to run
+        if ( generation != this->generation.loadAcquire())
+            return;
+
+#ifdef Q_OS_WIN
+        // shell icon functions require COM on the calling thread
+        const HRESULT hr = CoInitializeEx( nullptr, COINIT_APARTMENTTHREADED );
+#endif
+        const QImage image( job());
+#ifdef Q_OS_WIN
+        if ( SUCCEEDED( hr ))
+            CoUninitialize();
+#endif
+
+        QMetaObject::invokeMethod( this, [ this, key, image, generation ]() {
+            if ( generation != this->generation.loadAcquire())
+                return;
+
+            this->pending.remove( key );
+            emit this->finished( key, image );
+        }, Qt::QueuedConnection );
+    } );
+
+    return true;
+}
+
+/**
+ * @brief IconLoader::cancel discards all queued and running requests
+ */
+void IconLoader::cancel() {
+    this->generation.fetchAndAddOrdered( 1 );
+    this->pool.clear();
+    this->pending.clear();
+}
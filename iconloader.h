@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QAtomicInt>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <functional>
+
+/**
+ * @brief The IconLoader class runs icon extraction jobs on a worker pool
+ *
+ * Jobs are identified by a string key; requesting a key that is already
+ * queued does not schedule a second extraction. Results are delivered on
+ * the thread the loader lives in through the finished signal. Jobs must
+ * return a QImage, since QPixmap cannot be created outside the GUI thread.
+ */
+class IconLoader : public QObject {
+    Q_OBJECT
+
+public:
+    using Job = std::function<QImage()>;
+
+    explicit IconLoader( QObject *parent = nullptr );
+    ~IconLoader() override;
+    bool request( const QString &key, const Job &job );
+    bool isPending( const QString &key ) const { return this->pending.contains( key ); }
+
+public slots:
+    void cancel();
+
+signals:
+    void finished( const QString &key, const QImage &image );
+
+private:
+    QThreadPool pool;
+    QSet<QString> pending;
+    QAtomicInt generation;
+};
@@ -0,0 +1,398 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "iconpack.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <cstddef>
+#include <cstring>
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * @brief sync flushes Qt and OS buffers of the file to the disk
+ * @param file
+ * @return
+ */
+static bool sync( QFile &file ) {
+    if ( !file.flush())
+        return false;
+
+#ifdef Q_OS_WIN
+    return FlushFileBuffers( reinterpret_cast<HANDLE>( _get_osfhandle( file.handle()))) != 0;
+#else
+    return ::fsync( file.handle()) == 0;
+#endif
+}
+
+/*
+ * icon pack diagnostics, enable with QT_LOGGING_RULES="desktopview.pack.debug=true"
+ */
+Q_LOGGING_CATEGORY( packLog, "desktopview.pack", QtInfoMsg )
+
+/**
+ * @brief IconPack::instance
+ * @return
+ */
+IconPack *IconPack::instance() {
+    static IconPack pack( "cache/icons.pack" );
+    return &pack;
+}
+
+/**
+ * @brief IconPack::IconPack
+ * @param fileName
+ */
+IconPack::IconPack( const QString &fileName ) : file( fileName ) {
+    // appends must stay ordered, one writer is all the disk wants anyway
+    this->writer.setMaxThreadCount( 1 );
+
+    const QDir dir( QFileInfo( fileName ).absolutePath());
+    if ( !dir.exists())
+        dir.mkpath( "." );
+
+    if ( !this->open()) {
+        qWarning() << "IconPack: could not open" << fileName;
+        this->file.close();
+    }
+}
+
+/**
+ * @brief IconPack::~IconPack
+ */
+IconPack::~IconPack() {
+    this->flush();
+
+    for ( uchar *data : qAsConst( this->maps ))
+        this->file.unmap( data );
+
+    this->file.close();
+}
+
+/**
+ * @brief IconPack::hash FNV-1a
+ * @param key
+ * @return
+ */
+quint64 IconPack::hash( const QByteArray &key ) {
+    quint64 hash = 14695981039346656037ULL;
+
+    for ( const char c : key ) {
+        hash ^= static_cast<uchar>( c );
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief IconPack::open
+ * @return
+ */
+bool IconPack::open() {
+    Header header;
+
+    if ( !this->file.open( QIODevice::ReadWrite ))
+        return false;
+
+    if ( this->file.read( reinterpret_cast<char *>( &header ), sizeof( Header )) != sizeof( Header ) ||
+         std::memcmp( header.magic, "DVIP", 4 ) != 0 || header.version != IconPack::Version ||
+         header.used < sizeof( Header ) || header.used > static_cast<quint64>( this->file.size()))
+        return this->reset();
+
+    this->used = header.used;
+    if ( this->used == sizeof( Header ))
+        return true;
+
+    uchar *data = this->file.map( 0, static_cast<qint64>( this->used ));
+    if ( data == nullptr )
+        return this->reset();
+
+    quint64 live = 0;
+    this->scan( data + sizeof( Header ), sizeof( Header ), this->used, &live );
+
+    // rewrite the pack if more than half of it is superseded entries
+    if ( live * 2 < this->used - sizeof( Header )) {
+        QSaveFile out( this->file.fileName());
+        const bool written = this->compact( &out );
+
+        // mapped and open files cannot be replaced on windows
+        this->file.unmap( data );
+        this->file.close();
+        this->index.clear();
+
+        if ( written && out.commit())
+            return this->open();
+
+        return this->file.open( QIODevice::ReadWrite ) && this->reset();
+    }
+
+    this->maps << data;
+    return true;
+}
+
+/**
+ * @brief IconPack::reset truncates the pack to an empty header
+ * @return
+ */
+bool IconPack::reset() {
+    const Header header = { { 'D', 'V', 'I', 'P' }, IconPack::Version, sizeof( Header ) };
+
+    this->index.clear();
+    this->appended.clear();
+    this->used = 0;
+
+    if ( !this->file.resize( 0 ) || !this->file.seek( 0 ) ||
+         this->file.write( reinterpret_cast<const char *>( &header ), sizeof( Header )) != sizeof( Header ) || !this->file.flush())
+        return false;
+
+    this->used = sizeof( Header );
+    return true;
+}
+
+/**
+ * @brief IconPack::scan adds records to the in-memory index, later records win
+ * @param data mapped file contents starting at offset
+ * @param offset
+ * @param used
+ * @param live bytes held by current records
+ */
+void IconPack::scan( const uchar *data, quint64 offset, quint64 used, quint64 *live ) {
+    const quint64 start = offset;
+
+    while ( offset + sizeof( Record ) <= used ) {
+        Record record;
+        std::memcpy( &record, data + ( offset - start ), sizeof( Record ));
+
+        const quint64 size = IconPack::recordSize( record );
+        if ( record.width == 0 || record.height == 0 || record.bytesPerLine < record.width * 4 || offset + size > used ) {
+            qWarning() << "IconPack: corrupt record at" << offset;
+            break;
+        }
+
+        const auto it = this->index.constFind( record.hash );
+        if ( it != this->index.constEnd())
+            *live -= it->size;
+
+        this->index[record.hash] = Entry { data + ( offset - start ), size };
+        *live += size;
+        offset += size;
+    }
+}
+
+/**
+ * @brief IconPack::compact writes live records into a new pack
+ * @param out
+ * @return
+ */
+bool IconPack::compact( QSaveFile *out ) {
+    Header header = { { 'D', 'V', 'I', 'P' }, IconPack::Version, sizeof( Header ) };
+
+    if ( !out->open( QIODevice::WriteOnly ))
+        return false;
+
+    out->write( reinterpret_cast<const char *>( &header ), sizeof( Header ));
+    for ( const Entry &entry : qAsConst( this->index )) {
+        if ( out->write( reinterpret_cast<const char *>( entry.record ), static_cast<qint64>( entry.size )) != static_cast<qint64>( entry.size ))
+            return false;
+
+        header.used += entry.size;
+    }
+
+    qCDebug( packLog ) << "IconPack: compacted" << this->used << "to" << header.used << "bytes";
+    return out->seek( 0 ) && out->write( reinterpret_cast<const char *>( &header ), sizeof( Header )) == sizeof( Header );
+}
+
+/**
+ * @brief IconPack::image
+ * @param key
+ * @param validator must match the one stored with the image
+ * @return image wrapping the mapped file, valid while the pack is open
+ */
+QImage IconPack::image( const QString &key, quint64 validator ) const {
+    {
+        QMutexLocker locker( &this->mutex );
+        const auto cached = this->appended.constFind( key );
+        if ( cached != this->appended.constEnd())
+            return cached->validator == validator ? cached->image : QImage();
+    }
+
+    // the writer adds newly mapped records to the index
+    const QByteArray bytes( key.toUtf8());
+    const uchar *data;
+    {
+        QMutexLocker locker( &this->mutex );
+        const auto it = this->index.constFind( IconPack::hash( bytes ));
+        if ( it == this->index.constEnd())
+            return QImage();
+
+        data = it->record;
+    }
+
+    // colliding keys simply miss, mappings stay until the pack is closed
+    Record record;
+    std::memcpy( &record, data, sizeof( Record ));
+    if ( record.keyLength != static_cast<quint32>( bytes.length()) || std::memcmp( data + sizeof( Record ), bytes.constData(), record.keyLength ) != 0 )
+        return QImage();
+
+    if ( record.validator != validator )
+        return QImage();
+
+    return QImage( data + sizeof( Record ) + IconPack::align( record.keyLength ), static_cast<int>( record.width ), static_cast<int>( record.height ),
+                   static_cast<int>( record.bytesPerLine ), QImage::Format_ARGB32_Premultiplied );
+}
+
+/**
+ * @brief IconPack::contains
+ * @param key
+ * @param validator
+ * @return
+ */
+bool IconPack::contains( const QString &key, quint64 validator ) const {
+    return !this->image( key, validator ).isNull();
+}
+
+/**
+ * @brief IconPack::count
+ * @return
+ */
+int IconPack::count() const {
+    QMutexLocker locker( &this->mutex );
+    return this->index.count() + this->appended.count();
+}
+
+/**
+ * @brief IconPack::insert queues an image for the writer, it is served from memory right away
+ * @param key
+ * @param image
+ * @param validator
+ */
+void IconPack::insert( const QString &key, const QImage &image, quint64 validator ) {
+    if ( !this->isOpen() || image.isNull())
+        return;
+
+    QMutexLocker locker( &this->mutex );
+    this->appended[key] = Appended { image, validator };
+    this->queue[key] = Appended { image, validator };
+
+    if ( this->writing )
+        return;
+
+    this->writing = true;
+    QtConcurrent::run( &this->writer, [ this ]() { this->write(); } );
+}
+
+/**
+ * @brief IconPack::flush blocks until every queued image is on disk
+ */
+void IconPack::flush() {
+    this->writer.waitForDone();
+}
+
+/**
+ * @brief IconPack::write drains the queue, everything queued meanwhile forms the next batch
+ */
+void IconPack::write() {
+    forever {
+        Batch batch;
+        {
+            QMutexLocker locker( &this->mutex );
+            if ( this->queue.isEmpty()) {
+                this->writing = false;
+                return;
+            }
+
+            batch.swap( this->queue );
+        }
+
+        const quint64 start = this->used;
+        if ( !this->append( batch )) {
+            qWarning() << "IconPack: could not write" << batch.count() << "records";
+            continue;
+        }
+
+        // serve the committed records from the file, memory only holds what is not durable yet
+        uchar *data = this->file.map( static_cast<qint64>( start ), static_cast<qint64>( this->used - start ));
+        if ( data == nullptr ) {
+            qWarning() << "IconPack: could not map" << batch.count() << "records";
+            continue;
+        }
+
+        QMutexLocker locker( &this->mutex );
+        quint64 live = 0;
+        this->maps << data;
+        this->scan( data, start, this->used, &live );
+
+        for ( auto it = batch.constBegin(); it != batch.constEnd(); ++it ) {
+            // a newer image queued meanwhile stays until its own batch is written
+            const auto cached = this->appended.find( it.key());
+            if ( cached != this->appended.end() && cached->image.cacheKey() == it->image.cacheKey() && cached->validator == it->validator )
+                this->appended.erase( cached );
+        }
+    }
+}
+
+/**
+ * @brief IconPack::append writes records and then commits them all in the header
+ * @param batch
+ * @return
+ */
+bool IconPack::append( const Batch &batch ) {
+    quint64 used = this->used;
+
+    if ( !this->file.seek( static_cast<qint64>( used )))
+        return false;
+
+    for ( auto it = batch.constBegin(); it != batch.constEnd(); ++it ) {
+        const QImage converted( it->image.convertToFormat( QImage::Format_ARGB32_Premultiplied ));
+        const QByteArray bytes( it.key().toUtf8());
+        const Record record = { IconPack::hash( bytes ), static_cast<quint32>( bytes.length()), static_cast<quint32>( converted.width()),
+                                static_cast<quint32>( converted.height()), static_cast<quint32>( converted.bytesPerLine()), it->validator };
+        const QByteArray padding( 15, '\0' );
+        const qint64 keyPadding = static_cast<qint64>( IconPack::align( record.keyLength ) - record.keyLength );
+        const qint64 pixelPadding = static_cast<qint64>( IconPack::recordSize( record ) - sizeof( Record ) - IconPack::align( record.keyLength )) - converted.sizeInBytes();
+
+        if ( this->file.write( reinterpret_cast<const char *>( &record ), sizeof( Record )) != sizeof( Record ) ||
+             this->file.write( bytes ) != bytes.length() ||
+             this->file.write( padding.constData(), keyPadding ) != keyPadding ||
+             this->file.write( reinterpret_cast<const char *>( converted.constBits()), converted.sizeInBytes()) != converted.sizeInBytes() ||
+             this->file.write( padding.constData(), pixelPadding ) != pixelPadding )
+            return false;
+
+        used += IconPack::recordSize( record );
+    }
+
+    // records must be on disk before the header points past them
+    if ( !sync( this->file ) || !this->file.seek( offsetof( Header, used )) ||
+         this->file.write( reinterpret_cast<const char *>( &used ), sizeof( used )) != sizeof( used ) || !sync( this->file ))
+        return false;
+
+    this->used = used;
+    return true;
+}
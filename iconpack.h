@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QThreadPool>
+
+/*
+ * classes
+ */
+class QSaveFile;
+
+/**
+ * @brief The IconPack class is a single file icon cache
+ *
+ * Layout: a 16 byte header followed by append-only records, each holding
+ * the key, a validator and raw ARGB32_Premultiplied pixels. Lookups with a
+ * different validator than the stored one miss, so stale entries for
+ * changed files are never served. The file is mapped on open and
+ * images are wrapped without copying. Inserted entries are served from
+ * memory only until their batch is committed, then the new part of the
+ * file is mapped and they are dropped. Records past the committed length
+ * in the header (a torn append) are ignored.
+ *
+ * Inserts only queue the image; a single background writer appends the
+ * queued records in batches and commits each batch with one header
+ * update. Repeated inserts of a key before it is written keep the latest.
+ * Lookups may come from any thread.
+ */
+class IconPack {
+    Q_DISABLE_COPY( IconPack )
+
+public:
+    static IconPack *instance();
+    explicit IconPack( const QString &fileName );
+    ~IconPack();
+    bool isOpen() const { return this->file.isOpen(); }
+    QImage image( const QString &key, quint64 validator = 0 ) const;
+    bool contains( const QString &key, quint64 validator = 0 ) const;
+    void insert( const QString &key, const QImage &image, quint64 validator = 0 );
+    int count() const;
+    void flush();
+
+    static constexpr const quint32 Version = 3;
+
+private:
+    struct Header {
+        char magic[4];
+        quint32 version;
+        quint64 used;
+    };
+
+    struct Record {
+        quint64 hash;
+        quint32 keyLength;
+        quint32 width;
+        quint32 height;
+        quint32 bytesPerLine;
+        quint64 validator;
+    };
+
+    struct Entry {
+        const uchar *record;
+        quint64 size;
+    };
+
+    struct Appended {
+        QImage image;
+        quint64 validator;
+    };
+
+    using Batch = QHash<QString, Appended>;
+
+    static quint64 hash( const QByteArray &key );
+    static quint64 align( quint64 value ) { return ( value + 15 ) & ~static_cast<quint64>( 15 ); }
+    static quint64 recordSize( const Record &record ) { return sizeof( Record ) + IconPack::align( record.keyLength ) + IconPack::align( static_cast<quint64>( record.bytesPerLine ) * record.height ); }
+    bool open();
+    bool reset();
+    void scan( const uchar *data, quint64 offset, quint64 used, quint64 *live );
+    bool compact( QSaveFile *out );
+    void write();
+    bool append( const Batch &batch );
+    QFile file;
+    QList<uchar *> maps;
+    quint64 used = 0;
+    QHash<quint64, Entry> index;
+    QHash<QString, Appended> appended;
+    Batch queue;
+    bool writing = false;
+    mutable QMutex mutex;
+    QThreadPool writer;
+};
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "iconprovider.h"
+#ifdef Q_OS_WIN
+#include "win32iconprovider.h"
+#else
+#include "xdgiconprovider.h"
+#endif
+
+/**
+ * @brief IconProvider::instance
+ * @return platform backend
+ */
+IconProvider *IconProvider::instance() {
+#ifdef Q_OS_WIN
+    static Win32IconProvider provider;
+#else
+    static XdgIconProvider provider;
+#endif
+    return &provider;
+}
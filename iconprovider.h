@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QFileInfo>
+#include <QImage>
+
+/**
+ * @brief The IconProvider class is the platform icon backend used by the models
+ *
+ * Implementations are called from IconLoader worker threads and must be
+ * thread safe; they return QImage, never QPixmap.
+ */
+class IconProvider {
+public:
+    virtual ~IconProvider() = default;
+    static IconProvider *instance();
+
+    /**
+     * @brief fileImage
+     * @param info
+     * @param size preferred size, backends may return a different one
+     * @return
+     */
+    virtual QImage fileImage( const QFileInfo &info, int size ) const = 0;
+
+    /**
+     * @brief libraryImage returns a stock icon by its windows resource id
+     * @param resourceId
+     * @param size
+     * @param library shell32, imageres, ...
+     * @return
+     */
+    virtual QImage libraryImage( int resourceId, int size, const QString &library ) const = 0;
+};
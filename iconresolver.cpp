@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "iconresolver.h"
+#include "iconcache.h"
+#include "iconloader.h"
+#include "iconpack.h"
+#include "iconprovider.h"
+#include "mipchain.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QLoggingCategory>
+#include <QSharedPointer>
+#include <QtConcurrent>
+
+/*
+ * icon diagnostics, enable with QT_LOGGING_RULES="desktopview.icons.debug=true"
+ */
+Q_LOGGING_CATEGORY( iconLog, "desktopview.icons", QtInfoMsg )
+
+/**
+ * @brief IconResolver::IconResolver
+ * @param parent
+ */
+IconResolver::IconResolver( QObject *parent ) : QObject( parent ), loader( new IconLoader( this )) {
+    IconLoader::connect( this->loader, &IconLoader::finished, this, &IconResolver::iconLoaded );
+}
+
+/**
+ * @brief IconResolver::clear forgets pending requests and file classes
+ */
+void IconResolver::clear() {
+    this->loader->cancel();
+    this->waiting.clear();
+    this->validators.clear();
+    this->fallbacks.clear();
+    this->classifier.clear();
+}
+
+/**
+ * @brief IconResolver::setScale
+ * @param scale icon size in logical pixels
+ * @param devicePixelRatio of the screen the icons are shown on
+ * @return true if the size changed
+ */
+bool IconResolver::setScale( int scale, qreal devicePixelRatio ) {
+    if ( scale == this->scale() && qFuzzyCompare( devicePixelRatio, this->devicePixelRatio()))
+        return false;
+
+    // icons are resampled from cached mip chains, nothing else to drop
+    this->m_scale = scale;
+    this->m_devicePixelRatio = devicePixelRatio;
+    return true;
+}
+
+/**
+ * @brief IconResolver::pixmap
+ * @param file
+ * @return icon at the exact pixel size of the view
+ */
+QPixmap IconResolver::pixmap( const IconFile &file ) const {
+    const QString path( file.path );
+    const QPixmap pixmap( this->resolve( this->classifier.key( file ), this->classifier.validator( file ), path, [ path ]() {
+        return IconResolver::getIconImage( QFileInfo( path ));
+    } ));
+
+    // a generic icon is shown until the real one is extracted
+    return pixmap.isNull() ? this->placeholder( file.directory ) : pixmap;
+}
+
+/**
+ * @brief IconResolver::pixmap serves an icon that does not belong to a file
+ * @param key identifies the icon in the caches, loaded() names it once extracted
+ * @param extract runs on a worker thread
+ * @param fallback generic icon cached when extraction fails
+ * @return icon at the exact pixel size of the view, null until extracted
+ */
+QPixmap IconResolver::pixmap( const QString &key, const Extractor &extract, QFileIconProvider::IconType fallback ) const {
+    this->fallbacks[key] = fallback;
+    return this->resolve( key, 0, key, extract );
+}
+
+/**
+ * @brief IconResolver::cached
+ * @param key
+ * @return icon from the memory tier only, null if it is not there
+ */
+QPixmap IconResolver::cached( const QString &key ) const {
+    return IconCache::instance()->pixmap( this->cacheKey( key, 0 ));
+}
+
+/**
+ * @brief IconResolver::resolve looks up the memory tier and the icon pack, and queues an extraction on a miss
+ * @param key
+ * @param validator
+ * @param path named by loaded() once extracted
+ * @param extract
+ * @return icon at the exact pixel size of the view, null until extracted
+ */
+QPixmap IconResolver::resolve( const QString &key, quint64 validator, const QString &path, const Extractor &extract ) const {
+    const QString cacheKey( this->cacheKey( key, validator ));
+    const QPixmap pixmap( IconCache::instance()->pixmap( cacheKey ));
+    if ( !pixmap.isNull()) {
+        this->classifier.hit();
+        return pixmap;
+    }
+
+    // already being decoded by a prefetch
+    if ( this->prefetching.contains( cacheKey ))
+        return QPixmap();
+
+    // any size can be served from the mip chain on disk
+    const QImage chain( IconPack::instance()->image( key, validator ));
+    if ( !chain.isNull()) {
+        const QPixmap level( IconCache::fit( QPixmap::fromImage( MipChain::level( chain, this->pixelSize())), this->pixelSize(), this->devicePixelRatio()));
+        IconCache::instance()->insert( cacheKey, level );
+        this->classifier.hit();
+        return level;
+    }
+
+    // extract in background, items of the same type share a single request
+    if ( !this->waiting.contains( key, path ))
+        this->waiting.insert( key, path );
+
+    this->validators[key] = validator;
+    if ( this->loader->request( key, [ extract ]() { return MipChain::build( extract()); } ))
+        this->classifier.miss();
+    else
+        this->classifier.hit();
+
+    return QPixmap();
+}
+
+/**
+ * @brief IconResolver::placeholder
+ * @param directory
+ * @return generic icon shown until the real one is extracted
+ */
+QPixmap IconResolver::placeholder( bool directory ) const {
+    const QString placeholderKey( this->cacheKey( QString( "placeholder_%1" ).arg( directory ? "dir" : "file" ), 0 ));
+    QPixmap generic( IconCache::instance()->pixmap( placeholderKey ));
+    if ( generic.isNull()) {
+        generic = IconCache::fit( this->provider.icon( directory ? QFileIconProvider::Folder : QFileIconProvider::File ).pixmap( this->pixelSize()), this->pixelSize(), this->devicePixelRatio());
+        IconCache::instance()->insert( placeholderKey, generic );
+    }
+
+    return generic;
+}
+
+/**
+ * @brief IconResolver::prefetch decodes all cached icons of the given files in parallel
+ * @param files
+ *
+ * Runs when a listing arrives. Icons are decoded on the global pool while
+ * the event loop keeps running, and prefetched() is emitted once they are
+ * in the memory tier.
+ */
+void IconResolver::prefetch( const QFileInfoList &files ) {
+    QVector<IconFile> entries;
+    entries.reserve( files.count());
+    for ( const QFileInfo &info : files )
+        entries << IconFile::fromInfo( info );
+
+    this->prefetch( entries );
+}
+
+/**
+ * @brief IconResolver::prefetch
+ * @param files
+ */
+void IconResolver::prefetch( const QVector<IconFile> &files ) {
+    struct Item {
+        QString cacheKey;
+        QString key;
+        quint64 validator;
+        QImage image;
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int size = this->pixelSize();
+    const qreal ratio = this->devicePixelRatio();
+    QSharedPointer<QVector<Item>> items( new QVector<Item>());
+    for ( const IconFile &file : files ) {
+        const QString key( this->classifier.key( file ));
+        const quint64 validator = this->classifier.validator( file );
+        const QString cacheKey( this->cacheKey( key, validator ));
+
+        if ( this->prefetching.contains( cacheKey ) || IconCache::instance()->contains( cacheKey ))
+            continue;
+
+        this->prefetching << cacheKey;
+        *items << Item { cacheKey, key, validator, QImage() };
+    }
+
+    if ( items->isEmpty())
+        return;
+
+    // pixmaps have to be made on the GUI thread, once everything is decoded
+    auto *watcher( new QFutureWatcher<void>( this ));
+    QFutureWatcher<void>::connect( watcher, &QFutureWatcher<void>::finished, this, [ this, watcher, items, size, ratio, timer ]() {
+        int count = 0;
+        for ( const Item &item : qAsConst( *items )) {
+            this->prefetching.remove( item.cacheKey );
+            if ( item.image.isNull())
+                continue;
+
+            IconCache::instance()->insert( item.cacheKey, IconCache::fit( QPixmap::fromImage( item.image ), size, ratio ));
+            count++;
+        }
+
+        qCDebug( iconLog ) << "IconResolver: prefetched" << count << "of" << items->count() << "icons in" << timer.elapsed() << "ms";
+        watcher->deleteLater();
+
+        // rows painted in the meantime show placeholders
+        if ( count > 0 )
+            emit this->prefetched();
+    } );
+
+    // pack lookups are thread safe, the functor keeps the items alive if the resolver goes first
+    watcher->setFuture( QtConcurrent::map( *items, [ items, size ]( Item &item ) {
+        item.image = MipChain::level( IconPack::instance()->image( item.key, item.validator ), size );
+    } ));
+}
+
+/**
+ * @brief IconResolver::getIconImage
+ * @param info
+ * @return icon at the largest mip chain size
+ */
+QImage IconResolver::getIconImage( const QFileInfo &info ) {
+    return IconProvider::instance()->fileImage( info, MipChain::Levels[0] );
+}
+
+/**
+ * @brief IconResolver::cacheKey
+ * @param key
+ * @param validator
+ * @return memory cache key for the current icon size and pixel ratio
+ */
+QString IconResolver::cacheKey( const QString &key, quint64 validator ) const {
+    return QString( "%1_%2_%3@%4" ).arg( key, QString::number( validator, 16 ), QString::number( this->scale()), QString::number( this->devicePixelRatio()));
+}
+
+/**
+ * @brief IconResolver::iconLoaded
+ * @param key
+ * @param chain
+ */
+void IconResolver::iconLoaded( const QString &key, const QImage &chain ) {
+    const QStringList paths( this->waiting.values( key ));
+    const quint64 validator = this->validators.take( key );
+    const QString cacheKey( this->cacheKey( key, validator ));
+    const QPixmap pixmap( IconCache::fit( QPixmap::fromImage( MipChain::level( chain, this->pixelSize())), this->pixelSize(), this->devicePixelRatio()));
+    this->waiting.remove( key );
+
+    // cache the fallback too, so that failed extractions are not requeued on every paint
+    if ( pixmap.isNull()) {
+        const auto fallback = this->fallbacks.constFind( key );
+        if ( fallback != this->fallbacks.constEnd())
+            IconCache::instance()->insert( cacheKey, IconCache::fit( this->provider.icon( fallback.value()).pixmap( this->pixelSize()), this->pixelSize(), this->devicePixelRatio()));
+        else if ( !paths.isEmpty())
+            IconCache::instance()->insert( cacheKey, IconCache::fit( this->provider.icon( QFileInfo( paths.first())).pixmap( this->pixelSize()), this->pixelSize(), this->devicePixelRatio()));
+    } else {
+        IconCache::instance()->insert( cacheKey, pixmap );
+        IconPack::instance()->insert( key, chain, validator );
+    }
+
+    for ( const QString &path : paths )
+        emit this->loaded( path );
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include "iconclassifier.h"
+#include <QFileIconProvider>
+#include <QFileInfo>
+#include <QHash>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QVector>
+#include <functional>
+
+/*
+ * classes
+ */
+class IconLoader;
+
+/**
+ * @brief The IconResolver class serves file icons for models that list files
+ *
+ * Icons come from the memory cache, then the icon pack, and are otherwise
+ * extracted in the background while a generic placeholder is shown;
+ * loaded() then names every path that waited for the icon. Prefetched
+ * icons are decoded in the background as well, prefetched() follows.
+ * Items that are not files (shell folders) provide their own key and
+ * extraction, loaded() then names the key.
+ */
+class IconResolver : public QObject {
+    Q_OBJECT
+
+public:
+    using Extractor = std::function<QImage()>;
+
+    explicit IconResolver( QObject *parent = nullptr );
+    ~IconResolver() override = default;
+    QPixmap pixmap( const QFileInfo &info ) const { return this->pixmap( IconFile::fromInfo( info )); }
+    QPixmap pixmap( const IconFile &file ) const;
+    QPixmap pixmap( const QString &key, const Extractor &extract, QFileIconProvider::IconType fallback ) const;
+    QPixmap cached( const QString &key ) const;
+    void prefetch( const QFileInfoList &files );
+    void prefetch( const QVector<IconFile> &files );
+    int scale() const { return this->m_scale; }
+    qreal devicePixelRatio() const { return this->m_devicePixelRatio; }
+    int pixelSize() const { return qRound( this->scale() * this->devicePixelRatio()); }
+    bool setScale( int scale, qreal devicePixelRatio );
+    void invalidate( const QString &directory ) { this->classifier.invalidate( directory ); }
+    void invalidateFile( const QString &path ) { this->classifier.invalidateFile( path ); }
+    quint64 hits() const { return this->classifier.hits(); }
+    quint64 misses() const { return this->classifier.misses(); }
+    static QImage getIconImage( const QFileInfo &info );
+
+public slots:
+    void clear();
+
+signals:
+    void loaded( const QString &path );
+    void prefetched();
+
+private slots:
+    void iconLoaded( const QString &key, const QImage &chain );
+
+private:
+    QString cacheKey( const QString &key, quint64 validator ) const;
+    QPixmap resolve( const QString &key, quint64 validator, const QString &path, const Extractor &extract ) const;
+    QPixmap placeholder( bool directory ) const;
+    IconLoader *loader;
+    QFileIconProvider provider;
+    mutable IconClassifier classifier;
+    mutable QMultiHash<QString, QString> waiting;
+    mutable QHash<QString, quint64> validators;
+    mutable QHash<QString, QFileIconProvider::IconType> fallbacks;
+    QSet<QString> prefetching;
+    int m_scale = 48; // TODO: copy from ListView
+    qreal m_devicePixelRatio = 1.0;
+};
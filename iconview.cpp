@@ -37,12 +37,13 @@
 #include <QMenu>
 #include <QDesktopServices>
 #include <QSortFilterProxyModel>
-#include <QtWin>
 #include <QInputDialog>
+#include <QKeyEvent>
 #include <QLineEdit>
 #include <QScreen>
-#ifdef Q_OS_WIN
 #include <QSettings>
+#ifdef Q_OS_WIN
+#include <QtWin>
 #include <ShlObj.h>
 #endif
 
@@ -82,6 +83,18 @@ IconView::IconView( QWidget *parent ) : QListView( parent ) {
     const int size = QSettings().value( "icons/size", 48 ).toInt();
     this->setIconSize( QSize( size, size ));
 
+    // large folders are shown in chunks, laid out as they arrive
+    this->setLayoutMode( QListView::Batched );
+    this->setBatchSize( qMax( 1, QSettings().value( "view/chunkSize", 256 ).toInt()));
+    this->fetchTimer.setSingleShot( true );
+    this->fetchTimer.setInterval( 0 );
+    QTimer::connect( &this->fetchTimer, &QTimer::timeout, this, &IconView::fetchChunk );
+
+    // shows what has been typed so far
+    this->filterLabel->setAutoFillBackground( true );
+    this->filterLabel->setMargin( 4 );
+    this->filterLabel->hide();
+
 
     // TODO: can have a scroll bar (vertical)
 
@@ -98,20 +111,168 @@ QString IconView::getFilePath( const QModelIndex &index ) const {
         const QSortFilterProxyModel *proxyModel( qobject_cast<const QSortFilterProxyModel *>( index.model()));
         const MultiDirModel *dirModel( qobject_cast<const MultiDirModel *>( proxyModel->sourceModel()));
 
-        if ( dirModel != nullptr ) {
-            const QModelIndex sourceIndex( dirModel->mapToSource( proxyModel->mapToSource( index )));
-            const FileSystemModel *model( qobject_cast<const FileSystemModel*>( sourceIndex.model()));
+        if ( dirModel != nullptr )
+            return dirModel->filePath( proxyModel->mapToSource( index ));
+    }
+
+    return QString();
+}
+
+/**
+ * @brief IconView::setScale sets icon size for both the view and the models
+ * @param scale
+ */
+void IconView::setScale( int scale ) {
+    QSettings().setValue( "icons/size", scale );
+    this->setIconSize( QSize( scale, scale ));
+
+    const QSortFilterProxyModel *proxyModel( qobject_cast<const QSortFilterProxyModel *>( this->model()));
+    if ( proxyModel == nullptr )
+        return;
+
+    MultiDirModel *model( qobject_cast<MultiDirModel*>( proxyModel->sourceModel()));
+    if ( model != nullptr )
+        model->setScale( scale, this->devicePixelRatioF());
+}
+
+/**
+ * @brief IconView::setModel
+ * @param model
+ */
+void IconView::setModel( QAbstractItemModel *model ) {
+    QListView::setModel( model );
+
+    if ( model == nullptr )
+        return;
+
+    // list view relayouts everything on row changes, put items back where they were;
+    // layout changes (sorting) are left alone so the new order shows
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeInserted, this, &IconView::holdPositions );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &IconView::holdPositions );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeMoved, this, &IconView::holdPositions );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsInserted, this, &IconView::holdInserted );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsInserted, this, &IconView::releasePositions );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsRemoved, this, &IconView::releasePositions );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsMoved, this, &IconView::releasePositions );
+
+    // scrolling to the end fetches more too, this fills in the rest while idle
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsInserted, this, &IconView::scheduleFetch );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::modelReset, this, &IconView::scheduleFetch );
+    this->scheduleFetch();
+}
+
+/**
+ * @brief IconView::scheduleFetch fetches the next chunk once the event loop is idle
+ */
+void IconView::scheduleFetch() {
+    if ( this->model() != nullptr && this->model()->canFetchMore( QModelIndex()))
+        this->fetchTimer.start();
+}
+
+/**
+ * @brief IconView::fetchChunk
+ */
+void IconView::fetchChunk() {
+    if ( this->model() != nullptr && this->model()->canFetchMore( QModelIndex()))
+        this->model()->fetchMore( QModelIndex());
+}
+
+/**
+ * @brief IconView::holdPositions remembers positions before the model changes
+ */
+void IconView::holdPositions() {
+    // filtered items flow freely, positions are restored when the filter is cleared
+    if ( this->movement() == Static || this->viewMode() == QListView::ListMode || this->holding || !this->filterText().isEmpty())
+        return;
+
+    // held once until the layout settles, not once per fetched chunk
+    this->held = this->positions();
+    this->holding = true;
+}
+
+/**
+ * @brief IconView::holdInserted remembers inserted rows, only those are checked for overlaps
+ * @param first
+ * @param last
+ */
+void IconView::holdInserted( const QModelIndex &, int first, int last ) {
+    if ( !this->holding )
+        return;
 
-            if ( model != nullptr )
-                return model->filePath( sourceIndex );
+    for ( int y = first; y <= last; y++ )
+        this->inserted << QPersistentModelIndex( this->model()->index( y, 0 ));
+}
+
+/**
+ * @brief IconView::releasePositions reapplies held positions once the layout is done
+ */
+void IconView::releasePositions() {
+    if ( this->holding )
+        this->placementPending = true;
+}
+
+/**
+ * @brief IconView::isLaidOut
+ * @return true if the batched layout has created every item
+ */
+bool IconView::isLaidOut() const {
+    const int rows = this->model()->rowCount();
+    return rows == 0 || this->rectForIndex( this->model()->index( rows - 1, 0 )).isValid();
+}
 
-            const DesktopIconModel *desktopIconModel( qobject_cast<const DesktopIconModel*>( sourceIndex.model()));
-            if ( desktopIconModel != nullptr )
-                return desktopIconModel->filePath( sourceIndex );
+/**
+ * @brief IconView::placeItems puts items back where they were held, stored or restored
+ */
+void IconView::placeItems() {
+    // rows fetched since the positions were loaded still go where they were saved
+    QMap<QString, QPoint> positions( this->stored );
+    for ( auto it = this->held.constBegin(); it != this->held.constEnd(); ++it )
+        positions.insert( it.key(), it.value());
+
+    QModelIndexList rows;
+    if ( this->placeAll ) {
+        for ( int y = 0; y < this->model()->rowCount(); y++ )
+            rows << this->model()->index( y, 0 );
+    } else {
+        for ( const QPersistentModelIndex &index : qAsConst( this->inserted )) {
+            if ( index.isValid())
+                rows << index;
         }
     }
 
-    return QString();
+    this->held.clear();
+    this->inserted.clear();
+    this->holding = false;
+    this->placeAll = false;
+    this->placementPending = false;
+    this->placeItems( positions, rows );
+
+    // a later reload puts items back where they are now, not where they were saved
+    const QMap<QString, QPoint> current( this->positions());
+    for ( auto it = current.constBegin(); it != current.constEnd(); ++it )
+        this->stored.insert( it.key(), it.value());
+}
+
+/**
+ * @brief IconView::schedulePlacement places all items once the layout is done
+ */
+void IconView::schedulePlacement() {
+    this->placeAll = true;
+    this->placementPending = true;
+    this->scheduleDelayedItemsLayout();
+}
+
+/**
+ * @brief IconView::timerEvent
+ * @param event
+ */
+void IconView::timerEvent( QTimerEvent *event ) {
+    QListView::timerEvent( event );
+
+    // batched layout creates items a batch at a time and ignores positions for the rest,
+    // so place them after the last fetched chunk has been laid out
+    if ( this->placementPending && this->model() != nullptr && !this->model()->canFetchMore( QModelIndex()) && this->isLaidOut())
+        this->placeItems();
 }
 
 /**
@@ -123,23 +284,19 @@ void IconView::savePositions() {
 
     qDebug() << "SAVE";
 
+    // keep positions of rows that have not been fetched yet or are filtered out
+    const QMap<QString, QPoint> current( this->filterText().isEmpty() ? this->positions() : QMap<QString, QPoint>());
+    QMap<QString, QPoint> positions( this->stored );
+    for ( auto it = current.constBegin(); it != current.constEnd(); ++it )
+        positions.insert( it.key(), it.value());
 
-    const QSortFilterProxyModel *proxyModel( qobject_cast<const QSortFilterProxyModel *>( this->model()));
-    const MultiDirModel *model( qobject_cast<MultiDirModel*>( proxyModel->sourceModel()));
     QFile file( "positions.dat" );
     if ( file.open( QIODevice::WriteOnly )) {
         QDataStream out( &file );
 
-        for ( int y = 0; y < model->rowCount(); y++ ) {
-            if ( model == nullptr )
-                continue;
-
-            const QModelIndex proxyIndex( proxyModel->index( y, 0 ));
-            const QModelIndex index( proxyModel->mapToSource( proxyIndex ));
-            const QPoint position( this->rectForIndex( proxyIndex ).topLeft());
-
-            out << model->filePath( index );
-            out << position;
+        for ( auto it = positions.constBegin(); it != positions.constEnd(); ++it ) {
+            out << it.key();
+            out << it.value();
         }
 
         file.close();
@@ -147,7 +304,33 @@ void IconView::savePositions() {
 }
 
 /**
- * @brief IconView::restorePositions
+ * @brief IconView::positions
+ * @return current item positions by file path
+ */
+QMap<QString, QPoint> IconView::positions() const {
+    QMap<QString, QPoint> positions;
+    const QSortFilterProxyModel *proxyModel( qobject_cast<const QSortFilterProxyModel *>( this->model()));
+    if ( proxyModel == nullptr )
+        return positions;
+
+    const MultiDirModel *model( qobject_cast<MultiDirModel*>( proxyModel->sourceModel()));
+    if ( model == nullptr )
+        return positions;
+
+    for ( int y = 0; y < proxyModel->rowCount(); y++ ) {
+        const QModelIndex proxyIndex( proxyModel->index( y, 0 ));
+        const QRect rect( this->rectForIndex( proxyIndex ));
+
+        // not laid out yet, saved positions are kept for those
+        if ( rect.isValid())
+            positions[model->filePath( proxyModel->mapToSource( proxyIndex ))] = rect.topLeft();
+    }
+
+    return positions;
+}
+
+/**
+ * @brief IconView::restorePositions puts items back where they were, positions are read from disk only once
  */
 void IconView::restorePositions() {
     if ( this->movement() == Static || this->viewMode() == QListView::ListMode )
@@ -155,54 +338,67 @@ void IconView::restorePositions() {
 
     qDebug() << "RESTORE";
 
-    const QSortFilterProxyModel *proxyModel( qobject_cast<const QSortFilterProxyModel *>( this->model()));
-    const MultiDirModel *model( qobject_cast<MultiDirModel*>( proxyModel->sourceModel()));
-    QMap<QString, QPoint> positions;
+    // positions moved or stashed during this session win, saved ones only fill in new paths
+    if ( !this->restored ) {
+        QFile file( "positions.dat" );
+        if ( file.open( QIODevice::ReadOnly )) {
+            QDataStream in( &file );
 
-    QFile file( "positions.dat" );
-    if ( file.open( QIODevice::ReadOnly )) {
-        QDataStream in( &file );
+            while ( !in.atEnd()) {
+                QString fileName;
+                QPoint position;
 
-        while ( !in.atEnd()) {
-            QString fileName;
-            QPoint position;
+                in >> fileName >> position;
+                if ( !this->stored.contains( fileName ))
+                    this->stored[fileName] = position;
+            }
 
-            in >> fileName >> position;
-            positions[fileName] = position;
+            file.close();
         }
 
-        file.close();
+        this->restored = true;
     }
 
-    // first pass
-    for ( int y = 0; y < model->rowCount(); y++ ) {
-        if ( model == nullptr )
-            continue;
+    // filtered items flow freely, they are placed when the filter is cleared
+    if ( this->filterText().isEmpty())
+        this->schedulePlacement();
+}
 
-        const QModelIndex index( model->index( y, 0 ));
-        const QString fileName( model->filePath( index ));
+/**
+ * @brief IconView::placeItems places items at the given positions
+ * @param positions
+ * @param rows rows that are moved to free cells if they overlap
+ */
+void IconView::placeItems( const QMap<QString, QPoint> &positions, const QModelIndexList &rows ) {
+    const QSortFilterProxyModel *proxyModel( qobject_cast<const QSortFilterProxyModel *>( this->model()));
+    if ( proxyModel == nullptr )
+        return;
 
-        if ( positions.contains( fileName ))
-            this->setPositionForIndex( positions[fileName], proxyModel->mapFromSource( index ));
+    const MultiDirModel *model( qobject_cast<MultiDirModel*>( proxyModel->sourceModel()));
+    if ( model == nullptr )
+        return;
+
+    // first pass
+    // list view has laid every item out anew, so all of them go back
+    for ( int y = 0; y < proxyModel->rowCount(); y++ ) {
+        const QModelIndex proxyIndex( proxyModel->index( y, 0 ));
+        const auto it = positions.constFind( model->filePath( proxyModel->mapToSource( proxyIndex )));
+
+        if ( it != positions.constEnd())
+            this->setPositionForIndex( it.value(), proxyIndex );
     }
 
     // second pass
     // DETECT OVERLAPS
     // might be simpler to create internal grid and map items to grid?
     // but that wont work in free placement mode
-    for ( int y = 0; y < model->rowCount(); y++ ) {
-        if ( model == nullptr )
-            continue;
-
-        const QModelIndex index( model->index( y, 0 ));
-        const QString fileName( model->filePath( index ));
-
-
-        const QPoint pos( positions.contains( fileName ) ? positions[fileName] : this->visualRect( index ).topLeft());
+    for ( const QModelIndex &proxyIndex : rows ) {
+        const QString fileName( model->filePath( proxyModel->mapToSource( proxyIndex )));
+        const QPoint pos( positions.contains( fileName ) ? positions[fileName] : this->visualRect( proxyIndex ).topLeft());
 
         const QModelIndex under( this->indexAt( pos ));
-        if ( under.isValid() && QString::compare( fileName, model->filePath( under ))) {
-            qDebug() << "overlap" << model->fileName( index ) << model->fileName( under ) << pos << this->rectForIndex( under ).topLeft();
+        if ( under.isValid() && under != proxyIndex ) {
+            qDebug() << "overlap" << fileName << this->getFilePath( under ) << pos << this->rectForIndex( under ).topLeft();
 
             // find a spot to place the icon
             int posx = 0;
@@ -225,13 +421,79 @@ void IconView::restorePositions() {
                 }
 
                 qDebug() << "found a spot at" << posx << posy;
-                this->setPositionForIndex( QPoint( posx, posy ), proxyModel->mapFromSource( index ));
+                this->setPositionForIndex( QPoint( posx, posy ), proxyIndex );
                 break;
             }
         }
     }
 }
 
+/**
+ * @brief IconView::filterText
+ * @return text items are currently filtered by
+ */
+QString IconView::filterText() const {
+    const SortModel *sortModel( qobject_cast<const SortModel *>( this->model()));
+    return sortModel != nullptr ? sortModel->filterText() : QString();
+}
+
+/**
+ * @brief IconView::setFilterText shows only items whose name contains text
+ * @param text
+ */
+void IconView::setFilterText( const QString &text ) {
+    SortModel *sortModel( qobject_cast<SortModel *>( this->model()));
+    if ( sortModel == nullptr || text == sortModel->filterText())
+        return;
+
+    // remember the layout before items start flowing
+    const bool wasFiltered = !sortModel->filterText().isEmpty();
+    if ( !wasFiltered ) {
+        const QMap<QString, QPoint> current( this->positions());
+        for ( auto it = current.constBegin(); it != current.constEnd(); ++it )
+            this->stored.insert( it.key(), it.value());
+    }
+
+    sortModel->setFilterText( text );
+
+    if ( text.isEmpty()) {
+        this->filterLabel->hide();
+        if ( wasFiltered && this->movement() != Static && this->viewMode() != QListView::ListMode )
+            this->schedulePlacement();
+        return;
+    }
+
+    this->filterLabel->setText( IconView::tr( "Filter: %1" ).arg( text ));
+    this->filterLabel->adjustSize();
+    this->filterLabel->move( this->width() - this->filterLabel->width() - this->internalGridSize().width() / 4, this->internalGridSize().height() / 4 );
+    this->filterLabel->show();
+    this->filterLabel->raise();
+}
+
+/**
+ * @brief IconView::keyPressEvent filters items by name as the user types
+ * @param event
+ */
+void IconView::keyPressEvent( QKeyEvent *event ) {
+    QString filter( this->filterText());
+    const QString text( event->text());
+
+    if ( event->key() == Qt::Key_Escape && !filter.isEmpty()) {
+        filter.clear();
+    } else if ( event->key() == Qt::Key_Backspace && !filter.isEmpty()) {
+        filter.chop( 1 );
+    } else if ( !text.isEmpty() && text.at( 0 ).isPrint() && !( filter.isEmpty() && text.at( 0 ).isSpace()) &&
+                !( event->modifiers() & ( Qt::ControlModifier | Qt::AltModifier | Qt::MetaModifier ))) {
+        filter += text;
+    } else {
+        QListView::keyPressEvent( event );
+        return;
+    }
+
+    this->setFilterText( filter );
+    event->accept();
+}
+
 /**
  * @brief IconView::dropEvent
  * @param event
@@ -265,6 +527,18 @@ void IconView::dropEvent( QDropEvent *event ) {
             }
         }
     }
+
+    // a drop while positions are held must survive the pending placement, and any later reload
+    if ( this->filterText().isEmpty()) {
+        for ( const QModelIndex &index : this->selectedIndexes()) {
+            const QString path( this->getFilePath( index ));
+            const QPoint position( this->rectForIndex( index ).topLeft());
+
+            this->stored.insert( path, position );
+            if ( this->holding )
+                this->held.insert( path, position );
+        }
+    }
 }
 
 /**
@@ -300,22 +574,19 @@ void IconView::mouseReleaseEvent( QMouseEvent *event ) {
             //       also add spacing and grid size options
             const int iconSize = QSettings().value( "icons/size", 48 ).toInt();
             QAction *actionLargeIcons( viewMenu->addAction( IconView::tr( "Large icons" ), [ this ]() {
-                QSettings().setValue( "icons/size", 64 );
-                this->setIconSize( QSize( 64, 64 ));
+                this->setScale( 64 );
             } ));
             actionLargeIcons->setCheckable( true );
             actionLargeIcons->setChecked( iconSize == 64 );
 
             QAction *actionMediumIcons( viewMenu->addAction( IconView::tr( "Medium icons" ), [ this ]() {
-                QSettings().setValue( "icons/size", 48 );
-                this->setIconSize( QSize( 48, 48 ));
+                this->setScale( 48 );
             } ));
             actionMediumIcons->setCheckable( true );
             actionMediumIcons->setChecked( iconSize == 48 );
 
             QAction *actionSmallIcons( viewMenu->addAction( IconView::tr( "Small icons" ), [ this ]() {
-                QSettings().setValue( "icons/size", 32 );
-                this->setIconSize( QSize( 32, 32 ));
+                this->setScale( 32 );
             } ));
             actionSmallIcons->setCheckable( true );
             actionSmallIcons->setChecked( iconSize == 32 );
@@ -358,16 +629,16 @@ void IconView::mouseReleaseEvent( QMouseEvent *event ) {
 
 
             auto sort = [ this ]( SortModel::SortMode mode ) {
-                //const Movement movement = this->movement();
-                //this->setMovement( Static );
+                // an explicit sort replaces the arrangement, let the new order lay out
+                this->held.clear();
+                this->stored.clear();
+                this->inserted.clear();
+                this->holding = false;
+                this->placementPending = false;
+                this->placeAll = false;
 
                 SortModel *sortModel( qobject_cast<SortModel *>( this->model()));
-                sortModel->setSortMode( mode );
-                sortModel->sort( 0, Qt::DescendingOrder );
-                sortModel->sort( 0, Qt::AscendingOrder );
-
-
-                //this->setMovement( movement );
+                sortModel->resort( mode );
             };
 
             QMenu *sortMenu( menu.addMenu( IconView::tr( "Sort by" )));
@@ -504,6 +775,7 @@ void IconView::mouseReleaseEvent( QMouseEvent *event ) {
         if ( filePaths.isEmpty())
             return;
 
+#ifdef Q_OS_WIN
         auto getItem = []( const QString &filePath ) {
             ITEMIDLIST *itemIdList = nullptr;
             SHParseDisplayName( reinterpret_cast<const wchar_t*>( QDir::toNativeSeparators( filePath ).utf16()), nullptr, &itemIdList, 0, nullptr );
@@ -556,6 +828,7 @@ void IconView::mouseReleaseEvent( QMouseEvent *event ) {
         }
 
         DestroyMenu( popupMenu );
+#endif
     }
 }
 
@@ -23,8 +23,12 @@
  */
 #include <QListView>
 #include "itemdelegate.h"
+#include <QLabel>
 #include <QMainWindow>
+#include <QTimer>
+#ifdef Q_OS_WIN
 #include <Windows.h>
+#endif
 
 /**
  * @brief The IconView class
@@ -35,21 +39,50 @@ class IconView : public QListView {
 public:
     explicit IconView( QWidget *parent = nullptr );
     QSize internalGridSize() const { return this->m_internalGridSize; }
+#ifdef Q_OS_WIN
     HWND parentHWND;
+#endif
     QMainWindow *windowParent = nullptr;
     [[nodiscard]] QString getFilePath( const QModelIndex &index ) const;
+    void setModel( QAbstractItemModel *model ) override;
+    QMap<QString, QPoint> positions() const;
 
 public slots:
     void savePositions();
     void restorePositions();
     void setInternalGridSize( const QSize &size ) { this->m_internalGridSize = size; }
+    void setScale( int scale );
+    void setFilterText( const QString &text );
 
 protected:
     void dropEvent( QDropEvent *event ) override;
     void showEvent( QShowEvent *event ) override;
     void mouseReleaseEvent( QMouseEvent *event ) override;
+    void keyPressEvent( QKeyEvent *event ) override;
+    void timerEvent( QTimerEvent *event ) override;
+
+private slots:
+    void holdPositions();
+    void holdInserted( const QModelIndex &, int first, int last );
+    void releasePositions();
+    void scheduleFetch();
+    void fetchChunk();
 
 private:
+    QString filterText() const;
+    bool isLaidOut() const;
+    void placeItems();
+    void placeItems( const QMap<QString, QPoint> &positions, const QModelIndexList &rows );
+    void schedulePlacement();
     ItemDelegate *delegate = new ItemDelegate( this );
+    QMap<QString, QPoint> held;
+    QMap<QString, QPoint> stored;
+    bool restored = false;
+    QList<QPersistentModelIndex> inserted;
+    bool holding = false;
+    bool placeAll = false;
+    bool placementPending = false;
+    QTimer fetchTimer;
+    QLabel *filterLabel = new QLabel( this );
     QSize m_internalGridSize = QSize( 128, 96 );
 };
@@ -21,6 +21,7 @@
  */
 #include <QApplication>
 #include "itemdelegate.h"
+#include "iconcache.h"
 #include <QDebug>
 #include <QPainter>
 #include <QPainterPath>
@@ -164,7 +165,7 @@ void ItemDelegate::paint( QPainter *painter, const QStyleOptionViewItem &option,
         QTextOption to;
 
         // get pixmap and its dimensions
-        const QIcon icon( qvariant_cast<QIcon>( view->model()->data( index, Qt::DecorationRole )));
+        QPixmap pixmap( qvariant_cast<QPixmap>( view->model()->data( index, IconRoles::PixmapRole )));
         rect = option.rect;
         rect.setY( rect.y() + this->topMargin());
         const int width = option.decorationSize.width();
@@ -177,10 +178,13 @@ void ItemDelegate::paint( QPainter *painter, const QStyleOptionViewItem &option,
             rect.setWidth( width );
         }
 
-        // draw pixmap
+        // draw pixmap, models serving PixmapRole already match the decoration size and pixel ratio
         rect.setHeight( height );
-        const QPixmap pixmap( icon.pixmap( rect.size()));
-        painter->drawPixmap( rect, pixmap );
+        if ( pixmap.isNull())
+            pixmap = qvariant_cast<QIcon>( view->model()->data( index, Qt::DecorationRole )).pixmap( rect.size());
+
+        const QSize size( pixmap.size() / pixmap.devicePixelRatioF());
+        painter->drawPixmap( rect.x() + ( rect.width() - size.width()) / 2, rect.y() + ( rect.height() - size.height()) / 2, pixmap );
 
         // split text into multiple lines
         if ( cache.contains( text )) {
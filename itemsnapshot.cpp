@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "itemsnapshot.h"
+#include <algorithm>
+
+/**
+ * @brief ItemSnapshot::intern
+ * @param string
+ * @param table
+ * @param ids
+ * @return id of the string in table
+ */
+int ItemSnapshot::intern( const QString &string, QStringList &table, QHash<QString, int> &ids ) {
+    const auto it = ids.constFind( string );
+    if ( it != ids.constEnd())
+        return it.value();
+
+    const int id = table.count();
+    table << string;
+    ids.insert( string, id );
+    return id;
+}
+
+/**
+ * @brief ItemSnapshot::internName interns a name and indexes new ones for search
+ * @param name
+ * @return id of the name in the name table
+ */
+int ItemSnapshot::internName( const QString &name ) {
+    const int count = this->nameTable.count();
+    const int id = ItemSnapshot::intern( name, this->nameTable, this->nameIds );
+    if ( id == count )
+        this->nameIndex.add( id, name );
+
+    return id;
+}
+
+/**
+ * @brief ItemSnapshot::findNames
+ * @param text
+ * @return sorted ids of names that contain text, ignoring case
+ */
+QVector<int> ItemSnapshot::findNames( const QString &text ) const {
+    const QString folded( text.toCaseFolded());
+    QVector<int> ids;
+
+    // too short for trigrams, scan the distinct names instead
+    if ( folded.length() < TrigramIndex::Length ) {
+        for ( int y = 0; y < this->nameTable.count(); y++ ) {
+            if ( this->nameTable.at( y ).toCaseFolded().contains( folded ))
+                ids << y;
+        }
+        return ids;
+    }
+
+    for ( const int id : this->nameIndex.candidates( folded )) {
+        if ( this->nameTable.at( id ).toCaseFolded().contains( folded ))
+            ids << id;
+    }
+    return ids;
+}
+
+/**
+ * @brief ItemSnapshot::item
+ * @param row
+ * @return
+ */
+DesktopItem ItemSnapshot::item( int row ) const {
+    DesktopItem item;
+
+    item.name = this->name( row );
+    item.path = this->path( row );
+    item.size = this->size( row );
+    if ( this->lastModified( row ) != InvalidTime )
+        item.lastModified = QDateTime::fromMSecsSinceEpoch( this->lastModified( row ));
+    item.type = this->typeName( this->typeId( row ));
+    item.flags = this->flags( row );
+    return item;
+}
+
+/**
+ * @brief ItemSnapshot::append
+ * @param item
+ * @param source
+ */
+void ItemSnapshot::append( const DesktopItem &item, int source ) {
+    this->names << this->internName( item.name );
+    this->paths << ItemSnapshot::intern( item.path, this->pathTable, this->pathIds );
+    this->sizes << item.size;
+    this->times << ( item.lastModified.isValid() ? item.lastModified.toMSecsSinceEpoch() : InvalidTime );
+    this->types << ItemSnapshot::intern( item.type, this->typeTable, this->typeIds );
+    this->sources << source;
+    this->itemFlags << item.flags;
+}
+
+/**
+ * @brief ItemSnapshot::insert
+ * @param row
+ * @param items
+ * @param source
+ */
+void ItemSnapshot::insert( int row, const QVector<DesktopItem> &items, int source ) {
+    const int count = items.count();
+
+    this->names.insert( row, count, 0 );
+    this->paths.insert( row, count, 0 );
+    this->sizes.insert( row, count, 0 );
+    this->times.insert( row, count, InvalidTime );
+    this->types.insert( row, count, 0 );
+    this->sources.insert( row, count, source );
+    this->itemFlags.insert( row, count, Qt::NoItemFlags );
+
+    for ( int y = 0; y < count; y++ )
+        this->replace( row + y, items.at( y ), source );
+}
+
+/**
+ * @brief ItemSnapshot::replace
+ * @param row
+ * @param item
+ * @param source
+ */
+void ItemSnapshot::replace( int row, const DesktopItem &item, int source ) {
+    this->names[row] = this->internName( item.name );
+    this->paths[row] = ItemSnapshot::intern( item.path, this->pathTable, this->pathIds );
+    this->sizes[row] = item.size;
+    this->times[row] = item.lastModified.isValid() ? item.lastModified.toMSecsSinceEpoch() : InvalidTime;
+    this->types[row] = ItemSnapshot::intern( item.type, this->typeTable, this->typeIds );
+    this->sources[row] = source;
+    this->itemFlags[row] = item.flags;
+}
+
+/**
+ * @brief ItemSnapshot::remove
+ * @param row
+ * @param count
+ */
+void ItemSnapshot::remove( int row, int count ) {
+    // strings stay interned, tables are dropped on clear
+    this->names.remove( row, count );
+    this->paths.remove( row, count );
+    this->sizes.remove( row, count );
+    this->times.remove( row, count );
+    this->types.remove( row, count );
+    this->sources.remove( row, count );
+    this->itemFlags.remove( row, count );
+}
+
+/**
+ * @brief ItemSnapshot::move moves rows first..last before row
+ * @param first
+ * @param last
+ * @param row
+ */
+void ItemSnapshot::move( int first, int last, int row ) {
+    auto rotate = [ first, last, row ]( auto &column ) {
+        if ( row < first )
+            std::rotate( column.begin() + row, column.begin() + first, column.begin() + last + 1 );
+        else if ( row > last + 1 )
+            std::rotate( column.begin() + first, column.begin() + last + 1, column.begin() + row );
+    };
+
+    rotate( this->names );
+    rotate( this->paths );
+    rotate( this->sizes );
+    rotate( this->times );
+    rotate( this->types );
+    rotate( this->sources );
+    rotate( this->itemFlags );
+}
+
+/**
+ * @brief ItemSnapshot::clear
+ */
+void ItemSnapshot::clear() {
+    *this = ItemSnapshot();
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include "desktopitemsource.h"
+#include "trigramindex.h"
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include <limits>
+
+/**
+ * @brief The ItemSnapshot class stores item metadata column by column
+ *
+ * One array per field, indexed by row. Names, paths and types are
+ * interned into string tables and stored as ids, so rows that share a
+ * type share one string and comparing types is an integer compare.
+ * Modification times are kept as milliseconds since epoch. Names are
+ * also kept in a trigram index for substring search.
+ */
+class ItemSnapshot {
+public:
+    int count() const { return this->sizes.count(); }
+    DesktopItem item( int row ) const;
+    QString name( int row ) const { return this->nameTable.at( this->names.at( row )); }
+    int nameId( int row ) const { return this->names.at( row ); }
+    QString nameById( int id ) const { return this->nameTable.at( id ); }
+    int nameCount() const { return this->nameTable.count(); }
+    QVector<int> findNames( const QString &text ) const;
+    QString path( int row ) const { return this->pathTable.at( this->paths.at( row )); }
+    qint64 size( int row ) const { return this->sizes.at( row ); }
+    qint64 lastModified( int row ) const { return this->times.at( row ); }
+    int typeId( int row ) const { return this->types.at( row ); }
+    QString typeName( int id ) const { return this->typeTable.at( id ); }
+    int typeCount() const { return this->typeTable.count(); }
+    int source( int row ) const { return this->sources.at( row ); }
+    Qt::ItemFlags flags( int row ) const { return this->itemFlags.at( row ); }
+
+    void append( const DesktopItem &item, int source );
+    void insert( int row, const QVector<DesktopItem> &items, int source );
+    void replace( int row, const DesktopItem &item, int source );
+    void remove( int row, int count );
+    void move( int first, int last, int row );
+    void clear();
+
+    static constexpr const qint64 InvalidTime = std::numeric_limits<qint64>::min();
+
+private:
+    int internName( const QString &name );
+    static int intern( const QString &string, QStringList &table, QHash<QString, int> &ids );
+    QVector<int> names;
+    QVector<int> paths;
+    QVector<qint64> sizes;
+    QVector<qint64> times;
+    QVector<int> types;
+    QVector<int> sources;
+    QVector<Qt::ItemFlags> itemFlags;
+    QStringList nameTable;
+    QStringList pathTable;
+    QStringList typeTable;
+    QHash<QString, int> nameIds;
+    QHash<QString, int> pathIds;
+    QHash<QString, int> typeIds;
+    TrigramIndex nameIndex;
+};
@@ -21,6 +21,7 @@
 /*
  * includes
  */
+#include "iconprovider.h"
 #include "mainwindow.h"
 #include <QApplication>
 
@@ -46,6 +47,10 @@ int main( int argc, char *argv[] ) {
     QCoreApplication::setOrganizationDomain( "factory12.org" );
     QCoreApplication::setApplicationName( "desktopview" );
 
+    // the provider reads the icon theme, which must happen on the GUI thread
+    // before icon loader workers ask for it
+    IconProvider::instance();
+
     MainWindow w;
     w.showMaximized();
 
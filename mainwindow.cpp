@@ -27,9 +27,13 @@
 #include "ui_mainwindow.h"
 #include "multidirmodel.h"
 #include "desktopiconmodel.h"
+#include "directoryindex.h"
+#include "filesystemmodel.h"
 #include "mainwindow.h"
 #include "backgrounddialog.h"
 #include "sortmodel.h"
+#include "iconcache.h"
+#include "iconpack.h"
 #ifdef Q_OS_WIN
 #include <QPainter>
 #include <ShlObj.h>
@@ -52,7 +56,9 @@ MainWindow::MainWindow( QWidget *parent ) : QMainWindow( parent ), ui( new Ui::M
     // setup widgets
     this->ui->setupUi( this );
 
+#ifdef Q_OS_WIN
     this->ui->listView->parentHWND = reinterpret_cast<HWND>( this->winId());
+#endif
     this->ui->listView->windowParent = this;
 
     // load background image (temporary)
@@ -68,18 +74,28 @@ MainWindow::MainWindow( QWidget *parent ) : QMainWindow( parent ), ui( new Ui::M
     // initialize multi-directory model
     auto *model( new MultiDirModel());
 
+    // add a desktop directory, listed natively or through QFileSystemModel
+    const bool nativeIndex = QSettings().value( "desktop/nativeIndex", false ).toBool();
+    auto addDirectory = [ model, nativeIndex ]( const QString &path ) {
+        if ( nativeIndex ) {
+            auto *directoryIndex( new DirectoryIndex( path ));
+            model->add( directoryIndex );
+            DirectoryIndex::connect( directoryIndex, &DirectoryIndex::directoryLoaded, model, &MultiDirModel::sourceLoaded );
+            return;
+        }
+
+        auto *desktopModel( new FileSystemModel( path ));
+        desktopModel->setResolveSymlinks( false );
+        model->add( desktopModel );
+        FileSystemModel::connect( desktopModel, &FileSystemModel::directoryLoaded, model, &MultiDirModel::sourceLoaded );
+    };
+
     // add user desktop
-    auto *desktopModel( new FileSystemModel( QStandardPaths::standardLocations( QStandardPaths::DesktopLocation ).first()));
-    desktopModel->setResolveSymlinks( false );
-    model->add( desktopModel );
-    FileSystemModel::connect( desktopModel, &FileSystemModel::directoryLoaded, model, &MultiDirModel::reset );
+    addDirectory( QStandardPaths::standardLocations( QStandardPaths::DesktopLocation ).first());
 
     // add public desktop
     // FIXME::!!!
-    auto *publicDesktopModel( new FileSystemModel( "C:/Users/Public/Desktop" ));
-    publicDesktopModel->setResolveSymlinks( false );
-    model->add( publicDesktopModel );
-    FileSystemModel::connect( publicDesktopModel, &FileSystemModel::directoryLoaded, model, &MultiDirModel::reset );
+    addDirectory( "C:/Users/Public/Desktop" );
 
     // add special icons (PC, documents, etc.)
 #ifdef Q_OS_WIN
@@ -87,9 +103,6 @@ MainWindow::MainWindow( QWidget *parent ) : QMainWindow( parent ), ui( new Ui::M
     model->add( desktopIconModel );
 #endif
 
-    // reload model
-    model->reset();
-
     // restore item positions
     MultiDirModel::connect( model, &MultiDirModel::loaded, this->ui->listView, &IconView::restorePositions );
 
@@ -97,6 +110,10 @@ MainWindow::MainWindow( QWidget *parent ) : QMainWindow( parent ), ui( new Ui::M
     auto *sortModel( new SortModel());
     sortModel->setSourceModel( model );
     this->ui->listView->setModel( sortModel );
+
+    // reload model
+    model->setScale( QSettings().value( "icons/size", 48 ).toInt(), this->devicePixelRatioF());
+    model->reset();
 }
 
 /**
@@ -106,6 +123,12 @@ MainWindow::~MainWindow() {
     // save item positions
     this->ui->listView->savePositions();
 
+    // write out icons still queued for the cache
+    IconPack::instance()->flush();
+
+    // the memory tier is static, its pixmaps must go while QGuiApplication still exists
+    IconCache::instance()->clear();
+
     // clear widgets
     delete this->ui;
 }
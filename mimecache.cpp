@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "mimecache.h"
+#include "fileidentity.h"
+#include <QtConcurrent>
+
+/**
+ * @brief MimeCache::instance
+ * @return
+ */
+MimeCache *MimeCache::instance() {
+    static MimeCache cache;
+    return &cache;
+}
+
+/**
+ * @brief MimeCache::~MimeCache
+ */
+MimeCache::~MimeCache() {
+    this->workers.clear();
+    this->workers.waitForDone();
+}
+
+/**
+ * @brief MimeCache::resolve
+ * @param info
+ * @param match
+ * @return
+ */
+MimeCache::Entry MimeCache::resolve( const QFileInfo &info, Match match ) const {
+    Entry entry { FileIdentity::validator( info ), QString(), false, false };
+
+    if ( info.isDir()) {
+        entry.name = this->database.mimeTypeForFile( info, QMimeDatabase::MatchExtension ).name();
+        return entry;
+    }
+
+    const QList<QMimeType> types( this->database.mimeTypesForFileName( info.fileName()));
+    entry.ambiguous = types.count() != 1;
+
+    if ( entry.ambiguous && match == Content ) {
+        entry.name = this->database.mimeTypeForFile( info, QMimeDatabase::MatchDefault ).name();
+        entry.sniffed = true;
+        return entry;
+    }
+
+    entry.name = types.isEmpty() ? this->database.mimeTypeForFile( info, QMimeDatabase::MatchExtension ).name() : types.first().name();
+    return entry;
+}
+
+/**
+ * @brief MimeCache::name
+ * @param info
+ * @param match Content reads the file if its name is ambiguous
+ * @return
+ */
+QString MimeCache::name( const QFileInfo &info, Match match ) {
+    const QString path( info.absoluteFilePath());
+    const quint64 validator = FileIdentity::validator( info );
+
+    {
+        QReadLocker locker( &this->lock );
+        const auto it = this->entries.constFind( path );
+        if ( it != this->entries.constEnd() && it->validator == validator && ( match == Extension || !it->ambiguous || it->sniffed ))
+            return it->name;
+    }
+
+    const Entry entry( this->resolve( info, match ));
+    QWriteLocker locker( &this->lock );
+    this->entries.insert( path, entry );
+    return entry.name;
+}
+
+/**
+ * @brief MimeCache::classify resolves a batch of files by name on worker threads
+ * @param files
+ */
+void MimeCache::classify( const QFileInfoList &files ) {
+    const int threads = this->workers.maxThreadCount();
+    const int chunk = ( files.count() + threads - 1 ) / threads;
+
+    for ( int y = 0; y < files.count(); y += chunk ) {
+        const QFileInfoList part( files.mid( y, chunk ));
+        QtConcurrent::run( &this->workers, [ this, part ]() {
+            for ( const QFileInfo &info : part )
+                this->name( info );
+        } );
+    }
+}
+
+/**
+ * @brief MimeCache::wait blocks until batches queued by classify are done
+ */
+void MimeCache::wait() {
+    this->workers.waitForDone();
+}
+
+/**
+ * @brief MimeCache::clear
+ */
+void MimeCache::clear() {
+    QWriteLocker locker( &this->lock );
+    this->entries.clear();
+}
+
+/**
+ * @brief MimeCache::count
+ * @return
+ */
+int MimeCache::count() const {
+    QReadLocker locker( &this->lock );
+    return this->entries.count();
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QFileInfo>
+#include <QHash>
+#include <QMimeDatabase>
+#include <QReadWriteLock>
+#include <QThreadPool>
+
+/**
+ * @brief The MimeCache class is the shared MIME type lookup for all models
+ *
+ * Types are resolved from the file name; file contents are only read when
+ * the name matches no type or several, and the caller asks for Content.
+ * Results are kept per path and dropped once the file's validator (mtime,
+ * size) changes. Keying by path rather than identity is deliberate, as a
+ * rename can change the extension and so the type. Thread safe.
+ */
+class MimeCache {
+    Q_DISABLE_COPY( MimeCache )
+
+public:
+    enum Match {
+        Extension,
+        Content
+    };
+
+    static MimeCache *instance();
+    MimeCache() = default;
+    ~MimeCache();
+    QString name( const QFileInfo &info, Match match = Extension );
+    void classify( const QFileInfoList &files );
+    void wait();
+    void clear();
+    int count() const;
+
+private:
+    struct Entry {
+        quint64 validator;
+        QString name;
+        bool ambiguous;
+        bool sniffed;
+    };
+
+    Entry resolve( const QFileInfo &info, Match match ) const;
+    QMimeDatabase database;
+    QHash<QString, Entry> entries;
+    mutable QReadWriteLock lock;
+    QThreadPool workers;
+};
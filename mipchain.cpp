@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "mipchain.h"
+#include <QPainter>
+
+/**
+ * @brief downscale
+ * @param image
+ * @param scale
+ * @return
+ */
+static QImage downscale( const QImage &image, int scale ) {
+    QImage downScaled( image );
+
+    if ( image.isNull() || scale <= 0 )
+        return QImage();
+
+    if ( downScaled.width() == scale && downScaled.height() == scale )
+        return downScaled;
+
+    if ( downScaled.width() >= scale * 2 )
+        downScaled = downScaled.scaled( scale * 2, scale * 2, Qt::IgnoreAspectRatio, Qt::FastTransformation );
+
+    return downScaled.scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+}
+
+/**
+ * @brief MipChain::build
+ * @param source
+ * @return
+ */
+QImage MipChain::build( const QImage &source ) {
+    if ( source.isNull())
+        return QImage();
+
+    // largest level is the source itself, capped at the largest standard size
+    const int top = qMin( MipChain::Levels[0], qMax( source.width(), source.height()));
+    QList<int> sizes( QList<int>() << top );
+    for ( const int size : MipChain::Levels ) {
+        if ( size < top )
+            sizes << size;
+    }
+
+    int width = 0;
+    for ( const int size : qAsConst( sizes ))
+        width += size;
+
+    QImage chain( width, top, QImage::Format_ARGB32_Premultiplied );
+    chain.fill( Qt::transparent );
+
+    // each level is filtered from the previous one
+    QPainter painter( &chain );
+    painter.setCompositionMode( QPainter::CompositionMode_Source );
+    QImage level( source.convertToFormat( QImage::Format_ARGB32_Premultiplied ));
+    int x = 0;
+    for ( const int size : qAsConst( sizes )) {
+        level = downscale( level, size );
+        painter.drawImage( x, 0, level );
+        x += size;
+    }
+
+    return chain;
+}
+
+/**
+ * @brief MipChain::level returns the nearest level not smaller than size, scaled to size
+ * @param chain
+ * @param size
+ * @return
+ */
+QImage MipChain::level( const QImage &chain, int size ) {
+    if ( chain.isNull() || size <= 0 )
+        return QImage();
+
+    // walk from the largest level until the next one would be too small
+    int x = 0, current = chain.height();
+    for ( const int next : MipChain::Levels ) {
+        if ( next >= current )
+            continue;
+
+        if ( next < size || x + current + next > chain.width())
+            break;
+
+        x += current;
+        current = next;
+    }
+
+    return downscale( chain.copy( x, 0, current, current ), size );
+}
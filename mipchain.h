@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QImage>
+
+/**
+ * @brief The MipChain namespace packs an icon at several sizes into one image
+ *
+ * Levels are square and laid out left to right, largest first, in a strip
+ * as tall as the largest level. Only standard sizes not larger than the
+ * source are generated, so a 48px source yields 48, 32 and 16.
+ */
+namespace MipChain {
+static constexpr const int Levels[] = { 256, 128, 64, 48, 32, 16 };
+
+QImage build( const QImage &source );
+QImage level( const QImage &chain, int size );
+}
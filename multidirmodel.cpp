@@ -19,24 +19,400 @@
 /*
  * includes
  */
-#include "desktopiconmodel.h"
 #include "multidirmodel.h"
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QSettings>
+#include <QtConcurrent>
+#include <algorithm>
+
+/*
+ * model diagnostics, enable with QT_LOGGING_RULES="desktopview.model.debug=true"
+ */
+Q_LOGGING_CATEGORY( modelLog, "desktopview.model", QtInfoMsg )
 
 /**
- * @brief MultiDirModel::reset
+ * @brief MultiDirModel::MultiDirModel
+ * @param parent
  */
-void MultiDirModel::reset() {
-    this->beginResetModel();
-    this->cache.clear();
+MultiDirModel::MultiDirModel( QObject *parent ) : QAbstractListModel( parent ) {
+    // one build at a time, stale ones are dropped anyway
+    this->workers.setMaxThreadCount( 1 );
+    this->chunkSize = qMax( 1, QSettings().value( "view/chunkSize", 256 ).toInt());
+
+    // listings are complete once loaded, that is when the snapshot is built
+    MultiDirModel::connect( this, &MultiDirModel::loaded, this, &MultiDirModel::scheduleRebuild );
+    UpdateScheduler::connect( this->updates, &UpdateScheduler::apply, this, &MultiDirModel::applyUpdates );
+}
+
+/**
+ * @brief MultiDirModel::~MultiDirModel
+ */
+MultiDirModel::~MultiDirModel() {
+    this->generation++;
+    this->workers.waitForDone();
+}
+
+/**
+ * @brief MultiDirModel::offset
+ * @param model
+ * @return first row of a source in this model
+ */
+int MultiDirModel::offset( const QAbstractItemModel *model ) const {
+    return this->offsets.at( this->models.indexOf( const_cast<QAbstractItemModel*>( model )));
+}
+
+/**
+ * @brief MultiDirModel::shift moves the rows of all sources after model by delta
+ * @param model
+ * @param delta
+ */
+void MultiDirModel::shift( const QAbstractItemModel *model, int delta ) {
+    for ( int y = this->models.indexOf( const_cast<QAbstractItemModel*>( model )) + 1; y < this->offsets.count(); y++ )
+        this->offsets[y] += delta;
+}
+
+/**
+ * @brief MultiDirModel::source
+ * @param row
+ * @return index of the source showing the row
+ */
+int MultiDirModel::source( int row ) const {
+    // last source starting at or before the row
+    return static_cast<int>( std::upper_bound( this->offsets.constBegin(), this->offsets.constEnd(), row ) - this->offsets.constBegin()) - 1;
+}
+
+/**
+ * @brief MultiDirModel::add
+ * @param source
+ */
+void MultiDirModel::add( DesktopItemSource *source ) {
+    QAbstractItemModel *model( source->model());
+    const int count = this->resetting ? 0 : model->rowCount();
+    const int first = this->offsets.last();
+
+    // a source appended after everything was fetched shows its first chunk, the rest is fetched on demand
+    const int visible = this->fetched == first ? qMin( this->chunkSize, count ) : 0;
+
+    if ( visible > 0 )
+        this->beginInsertRows( QModelIndex(), first, first + visible - 1 );
+
+    this->models << model;
+    this->sources << source;
+    this->offsets << first + count;
+    this->invalidate();
+    this->scheduleRebuild();
+
+    if ( visible > 0 ) {
+        this->fetched += visible;
+        this->endInsertRows();
+    }
+
+    // forward late changes (such as asynchronously loaded icons)
+    QAbstractItemModel::connect( model, &QAbstractItemModel::dataChanged, this, [ this, model, source ]( const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles ) {
+        if ( this->resetting || topLeft.parent() != source->rootIndex())
+            return;
+
+        const int offset = this->offset( model );
+        const int last = qMin( offset + bottomRight.row(), this->fetched - 1 );
+        if ( roles.isEmpty() || roles.contains( Qt::DisplayRole ) || roles.contains( Qt::EditRole )) {
+            if ( this->snapshotValid && bottomRight.row() - topLeft.row() < MultiDirModel::IncrementalRows ) {
+                const int id = this->sources.indexOf( source );
+                for ( int y = topLeft.row(); y <= bottomRight.row(); y++ )
+                    this->m_snapshot.replace( offset + y, source->item( y ), id );
+            } else {
+                this->invalidate();
+                this->scheduleRebuild();
+            }
+        }
+
+        if ( offset + topLeft.row() <= last )
+            emit this->dataChanged( this->index( offset + topLeft.row(), 0 ), this->index( last, 0 ), roles );
+    } );
+
+    // new and deleted files only touch their own rows, rows past the fetched ones stay hidden
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeInserted, this, [ this, model, source ]( const QModelIndex &parent, int first, int last ) {
+        if ( this->resetting || parent != source->rootIndex())
+            return;
+
+        // rows appended to a fully fetched model are shown a chunk at a time, the rest is fetched on demand
+        const int row = this->offset( model ) + first;
+        if ( row < this->fetched )
+            this->forwarded = last - first + 1;
+        else if ( row == this->fetched && this->fetched == this->offsets.last())
+            this->forwarded = qMin( this->chunkSize, last - first + 1 );
+        else
+            this->forwarded = 0;
+
+        if ( this->forwarded > 0 )
+            this->beginInsertRows( QModelIndex(), row, row + this->forwarded - 1 );
+    } );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsInserted, this, [ this, model, source ]( const QModelIndex &parent, int first, int last ) {
+        if ( this->resetting || parent != source->rootIndex())
+            return;
+
+        // a directory listing arrives in large batches, the snapshot is rebuilt in bulk once it is loaded
+        const int count = last - first + 1;
+        if ( this->snapshotValid && count <= MultiDirModel::IncrementalRows ) {
+            QVector<DesktopItem> items;
+            for ( int y = first; y <= last; y++ )
+                items << source->item( y );
+
+            this->m_snapshot.insert( this->offset( model ) + first, items, this->sources.indexOf( source ));
+        } else {
+            this->invalidate();
+            if ( count <= MultiDirModel::IncrementalRows )
+                this->scheduleRebuild();
+        }
+
+        this->shift( model, count );
+        if ( this->forwarded > 0 ) {
+            this->fetched += this->forwarded;
+            this->forwarded = 0;
+            this->endInsertRows();
+        }
+    } );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeRemoved, this, [ this, model, source ]( const QModelIndex &parent, int first, int last ) {
+        if ( this->resetting || parent != source->rootIndex())
+            return;
+
+        const int row = this->offset( model ) + first;
+        this->forwarded = qMax( 0, qMin( this->offset( model ) + last + 1, this->fetched ) - row );
+        if ( this->forwarded > 0 )
+            this->beginRemoveRows( QModelIndex(), row, row + this->forwarded - 1 );
+    } );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsRemoved, this, [ this, model, source ]( const QModelIndex &parent, int first, int last ) {
+        if ( this->resetting || parent != source->rootIndex())
+            return;
+
+        if ( this->snapshotValid ) {
+            this->m_snapshot.remove( this->offset( model ) + first, last - first + 1 );
+        } else {
+            this->invalidate();
+            this->scheduleRebuild();
+        }
 
-    for ( const QAbstractItemModel *model : this->models ) {
-        for ( int y = 0; y < model->rowCount(); y++ )
-            this->cache << model->index( y, 0 );
+        this->shift( model, -( last - first + 1 ));
+        if ( this->forwarded > 0 ) {
+            this->fetched -= this->forwarded;
+            this->forwarded = 0;
+            this->endRemoveRows();
+        }
+    } );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeMoved, this, [ this, model, source ]( const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row ) {
+        if ( this->resetting || parent != source->rootIndex() || destination != parent )
+            return;
+
+        // moves across the fetched boundary change which rows are shown, simply reset
+        const int offset = this->offset( model );
+        if ( offset + last < this->fetched && offset + row <= this->fetched )
+            this->moving = this->beginMoveRows( QModelIndex(), offset + first, offset + last, QModelIndex(), offset + row );
+        else if ( offset + first < this->fetched || offset + row < this->fetched )
+            this->beginReset();
+    } );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsMoved, this, [ this, model, source ]( const QModelIndex &parent, int first, int last, const QModelIndex &destination, int row ) {
+        if ( parent != source->rootIndex() || destination != parent )
+            return;
+
+        // a move across the fetched boundary is done
+        if ( this->resetting ) {
+            this->endReset();
+            return;
+        }
+
+        // rows map straight through to the source, only the snapshot follows
+        if ( this->snapshotValid ) {
+            const int offset = this->offset( model );
+            this->m_snapshot.move( offset + first, offset + last, offset + row );
+        } else {
+            this->invalidate();
+            this->scheduleRebuild();
+        }
+
+        if ( this->moving ) {
+            this->moving = false;
+            this->endMoveRows();
+        }
+    } );
+
+    // resorting the source permutes rows, views keep their items through persistent indexes
+    QAbstractItemModel::connect( model, &QAbstractItemModel::layoutAboutToBeChanged, this, [ this ]() {
+        if ( this->resetting )
+            return;
+
+        emit this->layoutAboutToBeChanged();
+
+        this->layoutIndexes = this->persistentIndexList();
+        this->layoutSources.clear();
+        for ( const QModelIndex &index : qAsConst( this->layoutIndexes ))
+            this->layoutSources << QPersistentModelIndex( this->mapToSource( index ));
+    } );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::layoutChanged, this, [ this, model ]() {
+        if ( this->resetting )
+            return;
+
+        const int offset = this->offset( model );
+
+        QModelIndexList to;
+        for ( int y = 0; y < this->layoutIndexes.count(); y++ ) {
+            const QPersistentModelIndex &sourceIndex( this->layoutSources.at( y ));
+            to << ( sourceIndex.model() == model ? this->index( offset + sourceIndex.row(), 0 ) : this->layoutIndexes.at( y ));
+        }
+
+        this->changePersistentIndexList( this->layoutIndexes, to );
+        this->layoutIndexes.clear();
+        this->layoutSources.clear();
+        this->invalidate();
+        this->scheduleRebuild();
+        emit this->layoutChanged();
+    } );
+
+    // a source reset is mirrored as it happens, only the work that follows it is coalesced
+    QAbstractItemModel::connect( model, &QAbstractItemModel::modelAboutToBeReset, this, &MultiDirModel::beginReset );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::modelReset, this, &MultiDirModel::endReset );
+}
+
+/**
+ * @brief MultiDirModel::invalidate drops the snapshot and any build in flight
+ */
+void MultiDirModel::invalidate() {
+    this->snapshotValid = false;
+    this->m_snapshot.clear();
+    this->generation++;
+    emit this->snapshotChanged();
+}
+
+/**
+ * @brief MultiDirModel::scheduleRebuild rebuilds the snapshot once control returns to the event loop
+ */
+void MultiDirModel::scheduleRebuild() {
+    if ( this->rebuildPending )
+        return;
+
+    this->rebuildPending = true;
+    QMetaObject::invokeMethod( this, [ this ]() { this->rebuild(); }, Qt::QueuedConnection );
+}
+
+/**
+ * @brief MultiDirModel::rebuild fills the snapshot on worker threads
+ *
+ * Sources can only be read on the GUI thread, so rows are copied here and
+ * completed (types resolved) and packed into columns in the background.
+ * Changes made in the meantime bump the generation and the result is dropped.
+ */
+void MultiDirModel::rebuild() {
+    struct Pending {
+        DesktopItem item;
+        int source;
+    };
+
+    this->rebuildPending = false;
+    if ( this->snapshotValid || this->resetting )
+        return;
+
+    const int generation = ++this->generation;
+    QVector<Pending> items;
+    items.reserve( this->offsets.last());
+    for ( int y = 0; y < this->sources.count(); y++ ) {
+        for ( int row = 0; row < this->offsets.at( y + 1 ) - this->offsets.at( y ); row++ )
+            items << Pending { this->sources.at( y )->partialItem( row ), y };
     }
 
+    QtConcurrent::run( &this->workers, [ this, generation, items, sources = this->sources ]() mutable {
+        QElapsedTimer timer;
+        timer.start();
+
+        QtConcurrent::blockingMap( items, [ &sources ]( Pending &pending ) {
+            sources.at( pending.source )->completeItem( pending.item );
+        } );
+
+        ItemSnapshot snapshot;
+        for ( const Pending &pending : qAsConst( items ))
+            snapshot.append( pending.item, pending.source );
+
+        qCDebug( modelLog ) << "MultiDirModel: built snapshot of" << snapshot.count() << "items in" << timer.elapsed() << "ms";
+
+        QMetaObject::invokeMethod( this, [ this, generation, snapshot ]() {
+            if ( generation != this->generation )
+                return;
+
+            this->m_snapshot = snapshot;
+            this->snapshotValid = true;
+            emit this->snapshotChanged();
+        }, Qt::QueuedConnection );
+    } );
+}
+
+/**
+ * @brief MultiDirModel::beginReset opens a reset that is closed by endReset before control returns to the event loop
+ */
+void MultiDirModel::beginReset() {
+    if ( this->resetting )
+        return;
+
+    this->beginResetModel();
+    this->invalidate();
+    this->resetting = true;
+}
+
+/**
+ * @brief MultiDirModel::endReset recounts all sources and closes the reset
+ *
+ * The snapshot rebuild and the loaded signal that follow a reset are left
+ * to the next transaction, so a burst of source resets is only followed up once.
+ */
+void MultiDirModel::endReset() {
+    if ( !this->resetting )
+        return;
+
+    for ( int y = 0; y < this->models.count(); y++ )
+        this->offsets[y + 1] = this->offsets.at( y ) + this->models.at( y )->rowCount();
+
+    this->fetched = qMin( this->offsets.last(), this->chunkSize );
+    this->resetting = false;
     this->endResetModel();
-    emit this->loaded();
+
+    this->loadPending = true;
+    this->updates->notify();
+}
+
+/**
+ * @brief MultiDirModel::reset reloads all sources
+ */
+void MultiDirModel::reset() {
+    this->beginReset();
+    this->endReset();
+}
+
+/**
+ * @brief MultiDirModel::sourceLoaded schedules the loaded signal
+ */
+void MultiDirModel::sourceLoaded() {
+    this->loadPending = true;
+    this->updates->notify();
+}
+
+/**
+ * @brief MultiDirModel::applyUpdates completes everything scheduled within the last window at once
+ */
+void MultiDirModel::applyUpdates() {
+    if ( this->loadPending ) {
+        this->loadPending = false;
+        emit this->loaded();
+    }
+
+    qCDebug( modelLog ) << "MultiDirModel: applied" << this->updates->transactions() << "transactions for" << this->updates->notifications() << "notifications";
+}
+
+/**
+ * @brief MultiDirModel::setScale
+ * @param scale
+ * @param devicePixelRatio
+ */
+void MultiDirModel::setScale( int scale, qreal devicePixelRatio ) {
+    for ( DesktopItemSource *source : qAsConst( this->sources ))
+        source->setScale( scale, devicePixelRatio );
 }
 
 /**
@@ -44,7 +420,30 @@ void MultiDirModel::reset() {
  * @return
  */
 int MultiDirModel::rowCount( const QModelIndex & ) const {
-    return this->cache.count();
+    return qMin( this->fetched, this->offsets.last());
+}
+
+/**
+ * @brief MultiDirModel::canFetchMore
+ * @param parent
+ * @return
+ */
+bool MultiDirModel::canFetchMore( const QModelIndex &parent ) const {
+    return !parent.isValid() && !this->resetting && this->fetched < this->offsets.last();
+}
+
+/**
+ * @brief MultiDirModel::fetchMore shows the next chunk of rows
+ * @param parent
+ */
+void MultiDirModel::fetchMore( const QModelIndex &parent ) {
+    if ( !this->canFetchMore( parent ))
+        return;
+
+    const int count = qMin( this->chunkSize, this->offsets.last() - this->fetched );
+    this->beginInsertRows( QModelIndex(), this->fetched, this->fetched + count - 1 );
+    this->fetched += count;
+    this->endInsertRows();
 }
 
 /**
@@ -69,145 +468,102 @@ QVariant MultiDirModel::data( const QModelIndex &index, int role ) const {
  * @return
  */
 QModelIndex MultiDirModel::mapToSource( const QModelIndex &index ) const {
-    if ( this->cache.isEmpty() || !index.isValid() || index.row() < 0 || index.row() >= this->rowCount())
+    if ( !index.isValid() || index.row() < 0 || index.row() >= this->rowCount())
         return QModelIndex();
 
-    return this->cache.at( index.row());
+    const int source = this->source( index.row());
+    return this->models.at( source )->index( index.row() - this->offsets.at( source ), 0 );
 }
 
 /**
- * @brief MultiDirModel::fileName
+ * @brief MultiDirModel::item
  * @param index
  * @return
  */
-QString MultiDirModel::fileName( const QModelIndex &index ) const {
-    if ( index.isValid()) {
-        const QModelIndex sourceIndex( this->mapToSource( index ));
-        const FileSystemModel *model( qobject_cast<const FileSystemModel*>( sourceIndex.model()));
+DesktopItem MultiDirModel::item( const QModelIndex &index ) const {
+    if ( !index.isValid() || index.row() < 0 || index.row() >= this->rowCount())
+        return DesktopItem();
 
-        if ( model != nullptr )
-            return model->fileName( sourceIndex );
+    if ( this->snapshotValid )
+        return this->m_snapshot.item( index.row());
 
-        const DesktopIconModel *desktopIconModel( qobject_cast<const DesktopIconModel*>( sourceIndex.model()));
-        if ( desktopIconModel != nullptr )
-            return desktopIconModel->fileName( sourceIndex );
-    }
-    return QString();
+    const int source = this->source( index.row());
+    return this->sources.at( source )->item( index.row() - this->offsets.at( source ));
 }
 
 /**
- * @brief MultiDirModel::filePath
+ * @brief MultiDirModel::fileName
  * @param index
  * @return
  */
-QString MultiDirModel::filePath( const QModelIndex &index ) const {
-    if ( index.isValid()) {
-        const QModelIndex sourceIndex( this->mapToSource( index ));
-        const FileSystemModel *model( qobject_cast<const FileSystemModel*>( sourceIndex.model()));
-
-        if ( model != nullptr )
-            return model->filePath( sourceIndex );
+QString MultiDirModel::fileName( const QModelIndex &index ) const {
+    if ( this->snapshotValid && index.isValid())
+        return this->m_snapshot.name( index.row());
 
-        const DesktopIconModel *desktopIconModel( qobject_cast<const DesktopIconModel*>( sourceIndex.model()));
-        if ( desktopIconModel != nullptr )
-            return desktopIconModel->filePath( sourceIndex );
-    }
-    return QString();
+    return this->item( index ).name;
 }
 
 /**
- * @brief MultiDirModel::fileInfo
+ * @brief MultiDirModel::filePath
  * @param index
  * @return
  */
-QFileInfo MultiDirModel::fileInfo( const QModelIndex &index ) const {
-    if ( index.isValid()) {
-        const QModelIndex sourceIndex( this->mapToSource( index ));
-        const FileSystemModel *model( qobject_cast<const FileSystemModel*>( sourceIndex.model()));
-
-        if ( model != nullptr )
-            return model->fileInfo( sourceIndex );
+QString MultiDirModel::filePath( const QModelIndex &index ) const {
+    if ( this->snapshotValid && index.isValid())
+        return this->m_snapshot.path( index.row());
 
-    }
-    return QFileInfo();
+    return this->item( index ).path;
 }
 
 /**
- * @brief MultiDirModel::flags
+ * @brief MultiDirModel::mimeTypeName
  * @param index
  * @return
  */
-Qt::ItemFlags MultiDirModel::flags( const QModelIndex &index ) const {
-    if ( index.isValid()) {
-        const QModelIndex sourceIndex( this->mapToSource( index ));
-        const FileSystemModel *model( qobject_cast<const FileSystemModel*>( sourceIndex.model()));
-
-        if ( model != nullptr )
-            return model->flags( sourceIndex );
+QString MultiDirModel::mimeTypeName( const QModelIndex &index ) const {
+    if ( this->snapshotValid && index.isValid())
+        return this->m_snapshot.typeName( this->m_snapshot.typeId( index.row()));
 
-        const DesktopIconModel *desktopIconModel( qobject_cast<const DesktopIconModel*>( sourceIndex.model()));
-        if ( desktopIconModel != nullptr )
-            return desktopIconModel->flags( sourceIndex );
-    }
-    return QAbstractListModel::flags( index );
+    return this->item( index ).type;
 }
 
 /**
- * @brief MultiDirModel::mimeTypeName
+ * @brief MultiDirModel::size
  * @param index
  * @return
  */
-QString MultiDirModel::mimeTypeName( const QModelIndex &index ) const {
-    if ( index.isValid()) {
-        const QModelIndex sourceIndex( this->mapToSource( index ));
-        const FileSystemModel *model( qobject_cast<const FileSystemModel*>( sourceIndex.model()));
-
-        if ( model != nullptr )
-            return model->mimeTypeName( sourceIndex );
+qint64 MultiDirModel::size( const QModelIndex &index ) const {
+    if ( this->snapshotValid && index.isValid())
+        return this->m_snapshot.size( index.row());
 
-        const DesktopIconModel *desktopIconModel( qobject_cast<const DesktopIconModel*>( sourceIndex.model()));
-        if ( desktopIconModel != nullptr )
-            return desktopIconModel->mimeTypeName( sourceIndex );
-    }
-    return QString();
+    return this->item( index ).size;
 }
 
 /**
- * @brief MultiDirModel::size
+ * @brief MultiDirModel::lastModified
  * @param index
  * @return
  */
-qint64 MultiDirModel::size( const QModelIndex &index ) const {
-    if ( index.isValid()) {
-        const QModelIndex sourceIndex( this->mapToSource( index ));
-        const FileSystemModel *model( qobject_cast<const FileSystemModel*>( sourceIndex.model()));
-
-        if ( model != nullptr )
-            return model->size( sourceIndex );
-
-        const DesktopIconModel *desktopIconModel( qobject_cast<const DesktopIconModel*>( sourceIndex.model()));
-        if ( desktopIconModel != nullptr )
-            return desktopIconModel->size( sourceIndex );
+QDateTime MultiDirModel::lastModified( const QModelIndex &index ) const {
+    if ( this->snapshotValid && index.isValid()) {
+        const qint64 time = this->m_snapshot.lastModified( index.row());
+        return time == ItemSnapshot::InvalidTime ? QDateTime() : QDateTime::fromMSecsSinceEpoch( time );
     }
-    return -1;
+
+    return this->item( index ).lastModified;
 }
 
 /**
- * @brief MultiDirModel::lastModified
+ * @brief MultiDirModel::flags
  * @param index
  * @return
  */
-QDateTime MultiDirModel::lastModified( const QModelIndex &index ) const {
-    if ( index.isValid()) {
-        const QModelIndex sourceIndex( this->mapToSource( index ));
-        const FileSystemModel *model( qobject_cast<const FileSystemModel*>( sourceIndex.model()));
+Qt::ItemFlags MultiDirModel::flags( const QModelIndex &index ) const {
+    if ( !index.isValid())
+        return QAbstractListModel::flags( index );
 
-        if ( model != nullptr )
-            return model->fileInfo( sourceIndex ).lastModified();
+    if ( this->snapshotValid )
+        return this->m_snapshot.flags( index.row());
 
-        const DesktopIconModel *desktopIconModel( qobject_cast<const DesktopIconModel*>( sourceIndex.model()));
-        if ( desktopIconModel != nullptr )
-            return desktopIconModel->lastModified( sourceIndex );
-    }
-    return QDateTime();
+    return this->item( index ).flags;
 }
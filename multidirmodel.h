@@ -21,9 +21,12 @@
 /*
  * includes
  */
-#include "filesystemmodel.h"
+#include "desktopitemsource.h"
+#include "itemsnapshot.h"
+#include "updatescheduler.h"
 #include <QAbstractItemModel>
 #include <QIcon>
+#include <QThreadPool>
 
 /**
  * @brief The MultiDirModel class
@@ -32,29 +35,61 @@ class MultiDirModel : public QAbstractListModel {
     Q_OBJECT
 
 public:
-    explicit MultiDirModel( QObject *parent = nullptr ) : QAbstractListModel( parent ) {}
-    ~MultiDirModel() override = default;
+    explicit MultiDirModel( QObject *parent = nullptr );
+    ~MultiDirModel() override;
 
     int columnCount( const QModelIndex & ) const override { return 1; }
     int rowCount( const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore( const QModelIndex &parent ) const override;
+    void fetchMore( const QModelIndex &parent ) override;
     QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
     QModelIndex mapToSource( const QModelIndex &index ) const;
+    DesktopItem item( const QModelIndex &index ) const;
     QString fileName( const QModelIndex &index ) const;
     QString filePath( const QModelIndex &index ) const;
-    QFileInfo fileInfo( const QModelIndex &index ) const;
     Qt::ItemFlags flags( const QModelIndex &index ) const override;
     QString mimeTypeName( const QModelIndex &index ) const;
     qint64 size( const QModelIndex &index ) const;
     QDateTime lastModified( const QModelIndex &index ) const;
+    const ItemSnapshot *snapshot() const { return this->snapshotValid ? &this->m_snapshot : nullptr; }
+    const UpdateScheduler *scheduler() const { return this->updates; }
+    static constexpr const int IncrementalRows = 32;
 
 public slots:
-    void add( QAbstractItemModel *model ) { this->models << model; }
+    void add( DesktopItemSource *source );
     void reset();
+    void sourceLoaded();
+    void setScale( int scale, qreal devicePixelRatio = 1.0 );
 
 signals:
     void loaded();
+    void snapshotChanged();
 
 private:
+    int source( int row ) const;
+    int offset( const QAbstractItemModel *model ) const;
+    void shift( const QAbstractItemModel *model, int delta );
+    void beginReset();
+    void endReset();
+    void applyUpdates();
+    void invalidate();
+    void scheduleRebuild();
+    void rebuild();
     QList<QAbstractItemModel*> models;
-    mutable QList<QModelIndex> cache;
+    QList<DesktopItemSource*> sources;
+    QVector<int> offsets = QVector<int>() << 0;
+    QModelIndexList layoutIndexes;
+    QList<QPersistentModelIndex> layoutSources;
+    bool moving = false;
+    UpdateScheduler *updates = new UpdateScheduler( this );
+    bool resetting = false;
+    bool loadPending = false;
+    int fetched = 0;
+    int forwarded = 0;
+    int chunkSize = 256;
+    ItemSnapshot m_snapshot;
+    bool snapshotValid = false;
+    bool rebuildPending = false;
+    int generation = 0;
+    QThreadPool workers;
 };
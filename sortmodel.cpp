@@ -21,13 +21,290 @@
 /*
  * includes
  */
-#include "desktopiconmodel.h"
-#include "filesystemmodel.h"
 #include "multidirmodel.h"
 #include "sortmodel.h"
-#include <QMimeDatabase>
-#include <QDebug>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QSettings>
+#include <QThread>
+#include <QtConcurrent>
+#include <algorithm>
+#include <numeric>
+
+/*
+ * sort diagnostics, enable with QT_LOGGING_RULES="desktopview.sort.debug=true"
+ */
+Q_LOGGING_CATEGORY( sortLog, "desktopview.sort", QtInfoMsg )
+
+/**
+ * @brief parallelSort stable sorts chunks on the global pool and merges them pairwise
+ * @param rows
+ * @param lessThan must be thread safe
+ */
+template<typename Compare>
+static void parallelSort( QVector<int> &rows, const Compare &lessThan ) {
+    using Range = QPair<int, int>;
+
+    const int count = rows.count();
+    const int chunks = qMax( 1, QThread::idealThreadCount());
+    const int width = ( count + chunks - 1 ) / chunks;
+
+    QVector<Range> ranges;
+    for ( int start = 0; start < count; start += width )
+        ranges << Range( start, qMin( start + width, count ));
+
+    int *data = rows.data();
+    QtConcurrent::blockingMap( ranges, [ data, &lessThan ]( const Range &range ) {
+        std::stable_sort( data + range.first, data + range.second, lessThan );
+    } );
+
+    // each round halves the number of sorted runs
+    while ( ranges.count() > 1 ) {
+        QVector<Range> merged;
+        QVector<QPair<Range, Range>> pairs;
+        for ( int y = 0; y + 1 < ranges.count(); y += 2 ) {
+            pairs << qMakePair( ranges.at( y ), ranges.at( y + 1 ));
+            merged << Range( ranges.at( y ).first, ranges.at( y + 1 ).second );
+        }
+        if ( ranges.count() % 2 )
+            merged << ranges.last();
+
+        QtConcurrent::blockingMap( pairs, [ data, &lessThan ]( const QPair<Range, Range> &pair ) {
+            std::inplace_merge( data + pair.first.first, data + pair.second.first, data + pair.second.second, lessThan );
+        } );
+
+        ranges = merged;
+    }
+}
+
+/**
+ * @brief SortModel::SortModel
+ * @param parent
+ */
+SortModel::SortModel( QObject *parent ) : QSortFilterProxyModel( parent ) {
+    // new rows are placed by binary search and changed rows moved locally,
+    // only resort() and resets sort everything
+    this->setDynamicSortFilter( true );
+    this->collator.setNumericMode( QSettings().value( "sort/numeric", false ).toBool());
+}
+
+/**
+ * @brief SortModel::setSourceModel
+ * @param model
+ */
+void SortModel::setSourceModel( QAbstractItemModel *model ) {
+    if ( this->sourceModel() != nullptr )
+        QAbstractItemModel::disconnect( this->sourceModel(), nullptr, this, nullptr );
+
+    // ranks are by source row, drop them before the proxy maps any change
+    this->ranks.clear();
+    if ( model != nullptr ) {
+        auto clear = [ this ]() { this->ranks.clear(); };
+        QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeInserted, this, clear );
+        QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeRemoved, this, clear );
+        QAbstractItemModel::connect( model, &QAbstractItemModel::rowsAboutToBeMoved, this, clear );
+        QAbstractItemModel::connect( model, &QAbstractItemModel::layoutAboutToBeChanged, this, clear );
+        QAbstractItemModel::connect( model, &QAbstractItemModel::modelAboutToBeReset, this, clear );
+        QAbstractItemModel::connect( model, &QAbstractItemModel::dataChanged, this, [ this ]( const QModelIndex &, const QModelIndex &, const QVector<int> &roles ) {
+            if ( roles.isEmpty() || roles.contains( Qt::DisplayRole ) || roles.contains( Qt::EditRole ))
+                this->ranks.clear();
+        } );
+    }
+
+    QSortFilterProxyModel::setSourceModel( model );
+    this->multiDirModel = qobject_cast<const MultiDirModel*>( model );
+    this->nameKeys.clear();
+    this->m_typeRanks.clear();
+    this->updateMatches();
+
+    // keys and matches are indexed by name and type ids, which are only valid for one snapshot
+    if ( this->multiDirModel != nullptr ) {
+        MultiDirModel::connect( this->multiDirModel, &MultiDirModel::snapshotChanged, this, [ this ]() {
+            this->nameKeys.clear();
+            this->m_typeRanks.clear();
+
+            // rows without a match entry are tested directly, so the result is unchanged
+            this->updateMatches();
+        } );
+    }
+}
+
+/**
+ * @brief SortModel::setFilterText shows only items whose name contains text
+ * @param text
+ */
+void SortModel::setFilterText( const QString &text ) {
+    if ( text == this->m_filterText )
+        return;
+
+    this->m_filterText = text;
+    this->updateMatches();
+    this->invalidateFilter();
+}
+
+/**
+ * @brief SortModel::updateMatches looks up matching names once per filter change
+ */
+void SortModel::updateMatches() {
+    this->matchingNames.clear();
+
+    const ItemSnapshot *snapshot( this->multiDirModel != nullptr ? this->multiDirModel->snapshot() : nullptr );
+    if ( this->m_filterText.isEmpty() || snapshot == nullptr )
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    this->matchingNames.resize( snapshot->nameCount());
+    const QVector<int> ids( snapshot->findNames( this->m_filterText ));
+    for ( const int id : ids )
+        this->matchingNames.setBit( id );
+
+    qCDebug( sortLog ) << "filter" << this->m_filterText << "matched" << ids.count() << "of" << snapshot->nameCount() << "names in" << timer.elapsed() << "ms";
+}
+
+/**
+ * @brief SortModel::filterAcceptsRow
+ * @param sourceRow
+ * @return true if the name contains the filter text
+ */
+bool SortModel::filterAcceptsRow( int sourceRow, const QModelIndex & ) const {
+    if ( this->m_filterText.isEmpty())
+        return true;
+
+    // names seen when the filter was set are a bit test
+    if ( this->multiDirModel != nullptr ) {
+        const ItemSnapshot *snapshot( this->multiDirModel->snapshot());
+        if ( snapshot != nullptr && sourceRow < snapshot->count()) {
+            const int id = snapshot->nameId( sourceRow );
+            if ( id < this->matchingNames.size())
+                return this->matchingNames.testBit( id );
+        }
+    }
+
+    // names added since then are few, test them directly
+    const QModelIndex index( this->sourceModel()->index( sourceRow, 0 ));
+    const QString name( this->multiDirModel != nullptr ? this->multiDirModel->fileName( index ) : index.data( Qt::DisplayRole ).toString());
+    return name.toCaseFolded().contains( this->m_filterText.toCaseFolded());
+}
+
+/**
+ * @brief SortModel::setNumericMode sorts digits by value ("file2" before "file10")
+ * @param enable
+ */
+void SortModel::setNumericMode( bool enable ) {
+    if ( enable == this->numericMode())
+        return;
+
+    this->collator.setNumericMode( enable );
+    this->nameKeys.clear();
+    this->invalidate();
+}
+
+/**
+ * @brief SortModel::resort sorts by mode right away
+ * @param mode
+ * @param order
+ *
+ * The order of all source rows is worked out here in one go from the
+ * snapshot (in parallel for large models) and stored as ranks, the proxy
+ * then only compares integers while it rebuilds its mapping. Either way a
+ * single sort is run and a single layoutChanged is emitted.
+ */
+void SortModel::resort( SortMode mode, Qt::SortOrder order ) {
+    this->setSortMode( mode );
+
+    const ItemSnapshot *snapshot( this->multiDirModel != nullptr ? this->multiDirModel->snapshot() : nullptr );
+    if ( snapshot != nullptr ) {
+        QElapsedTimer timer;
+        timer.start();
+
+        // keys are made up front, so that workers only read them
+        if ( mode == Name && snapshot->nameCount() > 0 )
+            this->nameKey( snapshot, snapshot->nameCount() - 1 );
+
+        const QVector<QCollatorSortKey> &keys( this->nameKeys );
+        const QVector<int> &typeRanks( this->typeRanks( snapshot ));
+        auto lessThan = [ mode, snapshot, &keys, &typeRanks ]( int left, int right ) {
+            switch ( mode ) {
+            case Name:
+                return keys.at( snapshot->nameId( left )).compare( keys.at( snapshot->nameId( right ))) < 0;
+
+            case Type:
+                return typeRanks.at( snapshot->typeId( left )) < typeRanks.at( snapshot->typeId( right ));
+
+            case Size:
+                return snapshot->size( left ) < snapshot->size( right );
+
+            case Date:
+                return snapshot->lastModified( left ) < snapshot->lastModified( right );
+
+            case NoMode:
+                ;
+            }
+
+            return left < right;
+        };
+
+        QVector<int> rows( snapshot->count());
+        std::iota( rows.begin(), rows.end(), 0 );
+        if ( rows.count() >= SortModel::ParallelRows )
+            parallelSort( rows, lessThan );
+        else
+            std::stable_sort( rows.begin(), rows.end(), lessThan );
+
+        QVector<int> ranks( rows.count());
+        for ( int y = 0; y < rows.count(); y++ )
+            ranks[rows.at( y )] = y;
+        this->ranks = ranks;
+
+        qCDebug( sortLog ) << "ranked" << rows.count() << "rows by" << mode << "in" << timer.elapsed() << "ms";
+    }
+
+    // sort() does nothing if column and order are unchanged
+    if ( this->sortColumn() != 0 || this->sortOrder() != order )
+        this->sort( 0, order );
+    else
+        this->invalidate();
+}
+
+/**
+ * @brief SortModel::nameKey
+ * @param snapshot
+ * @param id
+ * @return collation key of an interned name, made once per name
+ */
+const QCollatorSortKey &SortModel::nameKey( const ItemSnapshot *snapshot, int id ) const {
+    while ( this->nameKeys.count() <= id )
+        this->nameKeys << this->collator.sortKey( snapshot->nameById( this->nameKeys.count()));
+
+    return this->nameKeys.at( id );
+}
+
+/**
+ * @brief SortModel::typeRanks
+ * @param snapshot
+ * @return alphabetical position of every interned type, indexed by type id
+ */
+const QVector<int> &SortModel::typeRanks( const ItemSnapshot *snapshot ) const {
+    // there are only a few types, new ones simply rank them all again
+    if ( this->m_typeRanks.count() != snapshot->typeCount()) {
+        QVector<int> ids( snapshot->typeCount());
+        std::iota( ids.begin(), ids.end(), 0 );
+        std::sort( ids.begin(), ids.end(), [ snapshot ]( int left, int right ) {
+            return QString::compare( snapshot->typeName( left ), snapshot->typeName( right )) < 0;
+        } );
+
+        this->m_typeRanks.resize( ids.count());
+        for ( int y = 0; y < ids.count(); y++ )
+            this->m_typeRanks[ids.at( y )] = y;
+
+        qCDebug( sortLog ) << "ranked" << ids.count() << "types";
+    }
+
+    return this->m_typeRanks;
+}
 
 /**
  * @brief SortModel::lessThan
@@ -36,7 +313,8 @@
  * @return
  */
 bool SortModel::lessThan( const QModelIndex &left, const QModelIndex &right ) const {
-
+    if ( left.row() < this->ranks.count() && right.row() < this->ranks.count())
+        return this->ranks.at( left.row()) < this->ranks.at( right.row());
 
     switch ( this->sortMode()) {
     case Name:
@@ -65,15 +343,15 @@ bool SortModel::lessThan( const QModelIndex &left, const QModelIndex &right ) co
  * @return
  */
 bool SortModel::sortByName( const QModelIndex &left, const QModelIndex &right ) const {
-    auto getFileName = []( const QModelIndex &index ) {
-        const MultiDirModel *model( qobject_cast<const MultiDirModel*>( index.model()));
-        return model != nullptr ?  model->fileName( index ) : QString();
-    };
+    if ( this->multiDirModel == nullptr )
+        return QSortFilterProxyModel::lessThan( left, right );
 
-    const QString leftName( getFileName( left ));
-    const QString rightName( getFileName( right ));
+    // keys compare bytewise, collation runs once per name instead of once per comparison
+    const ItemSnapshot *snapshot( this->multiDirModel->snapshot());
+    if ( snapshot != nullptr )
+        return this->nameKey( snapshot, snapshot->nameId( left.row())).compare( this->nameKey( snapshot, snapshot->nameId( right.row()))) < 0;
 
-    return QString::localeAwareCompare( leftName, rightName ) < 0;
+    return this->collator.compare( this->multiDirModel->fileName( left ), this->multiDirModel->fileName( right )) < 0;
 }
 
 /**
@@ -83,17 +361,17 @@ bool SortModel::sortByName( const QModelIndex &left, const QModelIndex &right )
  * @return
  */
 bool SortModel::sortByType( const QModelIndex &left, const QModelIndex &right ) const {
-    auto getMimeTypeName = []( const QModelIndex &index ) {
-        const MultiDirModel *model( qobject_cast<const MultiDirModel*>( index.model()));
-        return model != nullptr ?  model->mimeTypeName( index ) : QString();
-    };
+    if ( this->multiDirModel == nullptr )
+        return QSortFilterProxyModel::lessThan( left, right );
 
-    const QString leftName( getMimeTypeName( left ));
-    const QString rightName( getMimeTypeName( right ));
-
-    qDebug() << "less than called" << this->sortMode() << leftName << rightName << left << right;
+    // types are interned, ranking them once makes this an integer compare
+    const ItemSnapshot *snapshot( this->multiDirModel->snapshot());
+    if ( snapshot != nullptr ) {
+        const QVector<int> &ranks( this->typeRanks( snapshot ));
+        return ranks.at( snapshot->typeId( left.row())) < ranks.at( snapshot->typeId( right.row()));
+    }
 
-    return QString::compare( leftName, rightName ) < 0;
+    return QString::compare( this->multiDirModel->mimeTypeName( left ), this->multiDirModel->mimeTypeName( right )) < 0;
 }
 
 /**
@@ -103,15 +381,14 @@ bool SortModel::sortByType( const QModelIndex &left, const QModelIndex &right )
  * @return
  */
 bool SortModel::sortBySize( const QModelIndex &left, const QModelIndex &right ) const {
-    auto getFileSize = []( const QModelIndex &index ) {
-        const MultiDirModel *model( qobject_cast<const MultiDirModel*>( index.model()));
-        return model != nullptr ?  model->size( index ) : -1;
-    };
+    if ( this->multiDirModel == nullptr )
+        return QSortFilterProxyModel::lessThan( left, right );
 
-    const qint64 leftSize( getFileSize( left ));
-    const qint64 rightSize( getFileSize( right ));
+    const ItemSnapshot *snapshot( this->multiDirModel->snapshot());
+    if ( snapshot != nullptr )
+        return snapshot->size( left.row()) < snapshot->size( right.row());
 
-    return leftSize < rightSize;
+    return this->multiDirModel->size( left ) < this->multiDirModel->size( right );
 }
 
 /**
@@ -121,13 +398,13 @@ bool SortModel::sortBySize( const QModelIndex &left, const QModelIndex &right )
  * @return
  */
 bool SortModel::sortByDate( const QModelIndex &left, const QModelIndex &right ) const {
-    auto getFileDate = []( const QModelIndex &index ) {
-        const MultiDirModel *model( qobject_cast<const MultiDirModel*>( index.model()));
-        return model != nullptr ?  model->lastModified( index ) : QDateTime();
-    };
+    if ( this->multiDirModel == nullptr )
+        return QSortFilterProxyModel::lessThan( left, right );
 
-    const QDateTime leftDate( getFileDate( left ));
-    const QDateTime rightDate( getFileDate( right ));
+    // times were captured when the row was listed or last changed, nothing is read from disk here
+    const ItemSnapshot *snapshot( this->multiDirModel->snapshot());
+    if ( snapshot != nullptr )
+        return snapshot->lastModified( left.row()) < snapshot->lastModified( right.row());
 
-    return leftDate < rightDate;
+    return this->multiDirModel->lastModified( left ) < this->multiDirModel->lastModified( right );
 }
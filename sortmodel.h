@@ -21,8 +21,17 @@
 /*
  * includes
  */
+#include <QBitArray>
+#include <QCollator>
+#include <QCollatorSortKey>
 #include <QSortFilterProxyModel>
 
+/*
+ * classes
+ */
+class ItemSnapshot;
+class MultiDirModel;
+
 /**
  * @brief The SortModel class
  */
@@ -30,7 +39,7 @@ class SortModel : public QSortFilterProxyModel {
     Q_OBJECT
 
 public:
-    SortModel( QObject *parent = nullptr ) : QSortFilterProxyModel( parent ) {}
+    SortModel( QObject *parent = nullptr );
 
     enum SortMode {
         NoMode = -1,
@@ -42,14 +51,32 @@ public:
     Q_ENUM( SortMode )
 
     SortMode sortMode() const { return this->m_sortMode; }
+    void setSourceModel( QAbstractItemModel *model ) override;
+    bool numericMode() const { return this->collator.numericMode(); }
+    QString filterText() const { return this->m_filterText; }
+    static constexpr const int ParallelRows = 4096;
 
 public slots:
-    void setSortMode( SortMode mode ) { this->m_sortMode = mode; }
+    void setSortMode( SortMode mode ) { this->m_sortMode = mode; this->ranks.clear(); }
+    void setNumericMode( bool enable );
+    void resort( SortMode mode, Qt::SortOrder order = Qt::AscendingOrder );
+    void setFilterText( const QString &text );
 
 protected:
     bool lessThan( const QModelIndex &left, const QModelIndex &right ) const override;
+    bool filterAcceptsRow( int sourceRow, const QModelIndex &sourceParent ) const override;
 
 private:
+    const QCollatorSortKey &nameKey( const ItemSnapshot *snapshot, int id ) const;
+    const QVector<int> &typeRanks( const ItemSnapshot *snapshot ) const;
+    void updateMatches();
+    QCollator collator;
+    mutable QVector<QCollatorSortKey> nameKeys;
+    mutable QVector<int> m_typeRanks;
+    QVector<int> ranks;
+    QString m_filterText;
+    QBitArray matchingNames;
+    const MultiDirModel *multiDirModel = nullptr;
     SortMode m_sortMode = Name;
     bool sortByName( const QModelIndex &left, const QModelIndex &right ) const;
     bool sortByType( const QModelIndex &left, const QModelIndex &right ) const;
@@ -0,0 +1,15 @@
+QT       += core gui testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_alphascan
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../alphascan.cpp \
+    tst_alphascan.cpp
+
+HEADERS += \
+    ../../alphascan.h
@@ -0,0 +1,320 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "alphascan.h"
+#include <QRandomGenerator>
+#include <QVector>
+#include <QtTest>
+
+/**
+ * @brief The AlphaScanTest class checks the SIMD kernels against a per-pixel loop
+ */
+class AlphaScanTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void singlePixel_data();
+    void singlePixel();
+    void randomRows_data();
+    void randomRows();
+    void opaqueBounds();
+    void isJumbo_data();
+    void isJumbo();
+    void randomJumbo();
+    void scanRow_data();
+    void scanRow();
+
+private:
+    static int firstReference( const quint32 *row, int count );
+    static int lastReference( const quint32 *row, int count );
+    static bool jumboReference( const QImage &image );
+    static void kernels();
+};
+
+/*
+ * transparent pixels keep colour bits set, only alpha may decide
+ */
+static constexpr const quint32 Transparent = 0x00ffffffu;
+static constexpr const quint32 Faint = 0x01000000u;
+
+/**
+ * @brief AlphaScanTest::firstReference
+ * @param row
+ * @param count
+ * @return
+ */
+int AlphaScanTest::firstReference( const quint32 *row, int count ) {
+    for ( int x = 0; x < count; x++ ) {
+        if ( qAlpha( row[x] ) != 0 )
+            return x;
+    }
+    return -1;
+}
+
+/**
+ * @brief AlphaScanTest::lastReference
+ * @param row
+ * @param count
+ * @return
+ */
+int AlphaScanTest::lastReference( const quint32 *row, int count ) {
+    for ( int x = count - 1; x >= 0; x-- ) {
+        if ( qAlpha( row[x] ) != 0 )
+            return x;
+    }
+    return -1;
+}
+
+/**
+ * @brief AlphaScanTest::jumboReference is the per-pixel jumbo icon check the shell provider used before
+ * @param image
+ * @return
+ */
+bool AlphaScanTest::jumboReference( const QImage &image ) {
+    bool ok = false;
+
+    // test if most of the image is blank
+    if ( image.width() >= 64 && image.height() >= 64 ) {
+        for ( int x = 64; x < image.width(); x++ ) {
+            for ( int y = 64; y < image.height(); y++ ) {
+                if ( image.pixelColor( x, y ).alphaF() > 0.0 )
+                    ok = true;
+            }
+        }
+    }
+
+    // check if icon is really a small, but centered one
+    if ( ok && image.width() == 256 && image.height() == 256 ) {
+        const QVector<QRect> sides( QVector<QRect>() << QRect( 0, 0, 256, 64 ) << QRect( 0, 192, 256, 64 ) << QRect( 0, 0, 64, 256 ) << QRect( 192, 0, 64, 256 ));
+        bool blank = true;
+
+        for ( const QRect &side : sides ) {
+            for ( int x = side.left(); x <= side.right(); x++ ) {
+                for ( int y = side.top(); y <= side.bottom(); y++ ) {
+                    if ( image.pixelColor( x, y ).alphaF() > 0.0 )
+                        blank = false;
+                }
+            }
+        }
+
+        if ( blank )
+            ok = false;
+    }
+
+    return ok;
+}
+
+/**
+ * @brief AlphaScanTest::kernels adds a kernel column to data driven tests
+ */
+void AlphaScanTest::kernels() {
+    QTest::addColumn<int>( "kernel" );
+}
+
+/**
+ * @brief AlphaScanTest::singlePixel_data
+ */
+void AlphaScanTest::singlePixel_data() {
+    AlphaScanTest::kernels();
+    QTest::newRow( "sse2" ) << static_cast<int>( AlphaScan::SSE2 );
+    QTest::newRow( "avx2" ) << static_cast<int>( AlphaScan::AVX2 );
+}
+
+/**
+ * @brief AlphaScanTest::singlePixel puts one faint pixel at every position of odd and unaligned rows
+ */
+void AlphaScanTest::singlePixel() {
+    QFETCH( int, kernel );
+    if ( !AlphaScan::isSupported( static_cast<AlphaScan::Kernel>( kernel )))
+        QSKIP( "kernel not supported on this CPU" );
+
+    // widths around both vector sizes, starts off 16 and 32 byte boundaries
+    QVector<quint32> buffer( 80 + 8 );
+    for ( int offset = 0; offset < 8; offset++ ) {
+        for ( int width = 0; width <= 80; width++ ) {
+            quint32 *row = buffer.data() + offset;
+
+            for ( int position = -1; position < width; position++ ) {
+                std::fill( buffer.begin(), buffer.end(), Faint );
+                std::fill( row, row + width, Transparent );
+                if ( position != -1 )
+                    row[position] = Faint;
+
+                QCOMPARE( AlphaScan::firstOpaque( static_cast<AlphaScan::Kernel>( kernel ), row, width ), AlphaScanTest::firstReference( row, width ));
+                QCOMPARE( AlphaScan::lastOpaque( static_cast<AlphaScan::Kernel>( kernel ), row, width ), AlphaScanTest::lastReference( row, width ));
+            }
+        }
+    }
+}
+
+/**
+ * @brief AlphaScanTest::randomRows_data
+ */
+void AlphaScanTest::randomRows_data() {
+    this->singlePixel_data();
+}
+
+/**
+ * @brief AlphaScanTest::randomRows compares sparse random rows of odd widths
+ */
+void AlphaScanTest::randomRows() {
+    QFETCH( int, kernel );
+    if ( !AlphaScan::isSupported( static_cast<AlphaScan::Kernel>( kernel )))
+        QSKIP( "kernel not supported on this CPU" );
+
+    QRandomGenerator random( 12 );
+    QVector<quint32> buffer( 260 );
+    for ( int pass = 0; pass < 2000; pass++ ) {
+        const int offset = random.bounded( 4 );
+        const int width = random.bounded( 128 ) * 2 + 1;
+        quint32 *row = buffer.data() + offset;
+
+        for ( int x = 0; x < width; x++ )
+            row[x] = random.bounded( 16 ) == 0 ? random.generate() | Faint : random.generate() & Transparent;
+
+        QCOMPARE( AlphaScan::firstOpaque( static_cast<AlphaScan::Kernel>( kernel ), row, width ), AlphaScanTest::firstReference( row, width ));
+        QCOMPARE( AlphaScan::lastOpaque( static_cast<AlphaScan::Kernel>( kernel ), row, width ), AlphaScanTest::lastReference( row, width ));
+    }
+}
+
+/**
+ * @brief AlphaScanTest::opaqueBounds compares the bounding box with a per-pixel scan
+ */
+void AlphaScanTest::opaqueBounds() {
+    QRandomGenerator random( 34 );
+
+    for ( int pass = 0; pass < 200; pass++ ) {
+        QImage image( random.bounded( 1, 97 ), random.bounded( 1, 97 ), QImage::Format_ARGB32 );
+        image.fill( Qt::transparent );
+
+        const int count = random.bounded( 4 );
+        for ( int y = 0; y < count; y++ )
+            image.setPixel( random.bounded( image.width()), random.bounded( image.height()), Faint );
+
+        QRect expected;
+        for ( int y = 0; y < image.height(); y++ ) {
+            for ( int x = 0; x < image.width(); x++ ) {
+                if ( qAlpha( image.pixel( x, y )) != 0 )
+                    expected |= QRect( x, y, 1, 1 );
+            }
+        }
+
+        QCOMPARE( AlphaScan::opaqueBounds( image ), expected );
+    }
+}
+
+/**
+ * @brief AlphaScanTest::isJumbo_data
+ */
+void AlphaScanTest::isJumbo_data() {
+    QTest::addColumn<QSize>( "size" );
+    QTest::addColumn<QRect>( "opaque" );
+    QTest::addColumn<bool>( "jumbo" );
+
+    QTest::newRow( "blank" ) << QSize( 256, 256 ) << QRect() << false;
+    QTest::newRow( "too small" ) << QSize( 48, 48 ) << QRect( 0, 0, 48, 48 ) << false;
+    QTest::newRow( "exactly 64" ) << QSize( 64, 64 ) << QRect( 0, 0, 64, 64 ) << false;
+    QTest::newRow( "48 on top left" ) << QSize( 256, 256 ) << QRect( 0, 0, 48, 48 ) << false;
+    QTest::newRow( "64 on top left" ) << QSize( 256, 256 ) << QRect( 0, 0, 64, 64 ) << false;
+    QTest::newRow( "full" ) << QSize( 256, 256 ) << QRect( 0, 0, 256, 256 ) << true;
+    QTest::newRow( "centered" ) << QSize( 256, 256 ) << QRect( 64, 64, 128, 128 ) << false;
+    QTest::newRow( "centered pixel" ) << QSize( 256, 256 ) << QRect( 64, 64, 1, 1 ) << false;
+    QTest::newRow( "past center right" ) << QSize( 256, 256 ) << QRect( 64, 64, 129, 128 ) << true;
+    QTest::newRow( "past center bottom" ) << QSize( 256, 256 ) << QRect( 64, 64, 128, 129 ) << true;
+    QTest::newRow( "bottom right pixel" ) << QSize( 256, 256 ) << QRect( 255, 255, 1, 1 ) << true;
+    QTest::newRow( "left column only" ) << QSize( 256, 256 ) << QRect( 0, 0, 64, 256 ) << false;
+    QTest::newRow( "top row only" ) << QSize( 256, 256 ) << QRect( 0, 0, 256, 64 ) << false;
+    QTest::newRow( "across the corner" ) << QSize( 256, 256 ) << QRect( 32, 32, 64, 64 ) << true;
+    QTest::newRow( "not 256, centered" ) << QSize( 128, 128 ) << QRect( 64, 64, 32, 32 ) << true;
+    QTest::newRow( "not square" ) << QSize( 256, 96 ) << QRect( 200, 80, 8, 8 ) << true;
+}
+
+/**
+ * @brief AlphaScanTest::isJumbo checks the jumbo icon decision on hand picked shapes
+ */
+void AlphaScanTest::isJumbo() {
+    QFETCH( QSize, size );
+    QFETCH( QRect, opaque );
+    QFETCH( bool, jumbo );
+
+    QImage image( size, QImage::Format_ARGB32 );
+    image.fill( Qt::transparent );
+    for ( int y = opaque.top(); y <= opaque.bottom(); y++ ) {
+        for ( int x = opaque.left(); x <= opaque.right(); x++ )
+            image.setPixel( x, y, Faint );
+    }
+
+    QCOMPARE( AlphaScanTest::jumboReference( image ), jumbo );
+    QCOMPARE( AlphaScan::isJumbo( image ), jumbo );
+}
+
+/**
+ * @brief AlphaScanTest::randomJumbo compares the jumbo icon decision with the per-pixel check on sparse images
+ */
+void AlphaScanTest::randomJumbo() {
+    QRandomGenerator random( 56 );
+    const QVector<int> sizes( QVector<int>() << 48 << 64 << 65 << 128 << 256 << 256 << 256 );
+
+    for ( int pass = 0; pass < 300; pass++ ) {
+        const int size = sizes.at( random.bounded( sizes.count()));
+        QImage image( size, size, QImage::Format_ARGB32_Premultiplied );
+        image.fill( Qt::transparent );
+
+        const int count = random.bounded( 4 );
+        for ( int y = 0; y < count; y++ )
+            image.setPixel( random.bounded( size ), random.bounded( size ), Faint );
+
+        QCOMPARE( AlphaScan::isJumbo( image ), AlphaScanTest::jumboReference( image ));
+    }
+}
+
+/**
+ * @brief AlphaScanTest::scanRow_data
+ */
+void AlphaScanTest::scanRow_data() {
+    AlphaScanTest::kernels();
+    QTest::newRow( "scalar" ) << static_cast<int>( AlphaScan::Scalar );
+    QTest::newRow( "sse2" ) << static_cast<int>( AlphaScan::SSE2 );
+    QTest::newRow( "avx2" ) << static_cast<int>( AlphaScan::AVX2 );
+}
+
+/**
+ * @brief AlphaScanTest::scanRow benchmarks a 256 pixel jumbo icon row with its only opaque pixel in the middle
+ */
+void AlphaScanTest::scanRow() {
+    QFETCH( int, kernel );
+    if ( !AlphaScan::isSupported( static_cast<AlphaScan::Kernel>( kernel )))
+        QSKIP( "kernel not supported on this CPU" );
+
+    QVector<quint32> row( 256, Transparent );
+    row[128] = Faint;
+
+    int found = 0;
+    QBENCHMARK {
+        found += AlphaScan::firstOpaque( static_cast<AlphaScan::Kernel>( kernel ), row.constData(), row.count());
+        found += AlphaScan::lastOpaque( static_cast<AlphaScan::Kernel>( kernel ), row.constData(), row.count());
+    }
+    QVERIFY( found > 0 );
+}
+
+QTEST_APPLESS_MAIN( AlphaScanTest )
+
+#include "tst_alphascan.moc"
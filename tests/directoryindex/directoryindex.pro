@@ -0,0 +1,49 @@
+QT       += core gui widgets concurrent testlib
+win32:QT += winextras
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_directoryindex
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../alphascan.cpp \
+    ../../directoryindex.cpp \
+    ../../fileidentity.cpp \
+    ../../filesystemmodel.cpp \
+    ../../iconcache.cpp \
+    ../../iconclassifier.cpp \
+    ../../iconloader.cpp \
+    ../../iconpack.cpp \
+    ../../iconprovider.cpp \
+    ../../iconresolver.cpp \
+    ../../mimecache.cpp \
+    ../../mipchain.cpp \
+    tst_directoryindex.cpp
+
+HEADERS += \
+    ../../alphascan.h \
+    ../../desktopitemsource.h \
+    ../../directoryindex.h \
+    ../../fileidentity.h \
+    ../../filesystemmodel.h \
+    ../../iconcache.h \
+    ../../iconclassifier.h \
+    ../../iconloader.h \
+    ../../iconpack.h \
+    ../../iconprovider.h \
+    ../../iconresolver.h \
+    ../../mimecache.h \
+    ../../mipchain.h
+
+win32 {
+    SOURCES += ../../win32iconprovider.cpp
+    HEADERS += ../../win32iconprovider.h
+} else {
+    SOURCES += ../../xdgiconprovider.cpp
+    HEADERS += ../../xdgiconprovider.h
+}
+
+win32:LIBS += -lgdi32 -luser32 -luuid -lole32
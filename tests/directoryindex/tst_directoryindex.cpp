@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "directoryindex.h"
+#include "filesystemmodel.h"
+#include "mimecache.h"
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QtTest>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/**
+ * @brief The DirectoryIndexTest class compares the directory index with FileSystemModel on the same folder
+ */
+class DirectoryIndexTest : public QObject {
+    Q_OBJECT
+
+public:
+    enum Engine {
+        Index,
+        FileSystem
+    };
+    Q_ENUM( Engine )
+
+private slots:
+    void initTestCase();
+    void sameEntries();
+    void memory_data();
+    void memory();
+    void scan_data();
+    void scan();
+
+private:
+    DesktopItemSource *open( Engine engine ) const;
+    static bool waitForRows( DesktopItemSource *source, int count );
+    static qint64 heapInUse();
+    QTemporaryDir settings;
+    QTemporaryDir dir;
+};
+
+/*
+ * files and folders in the scanned directory
+ */
+static constexpr const int Files = 10000;
+static constexpr const int Folders = 20;
+
+/**
+ * @brief DirectoryIndexTest::initTestCase fills the folder and keeps settings away from the user's
+ */
+void DirectoryIndexTest::initTestCase() {
+#ifdef __GLIBC__
+    // one arena, so that the heap totals include what scanner threads allocate
+    mallopt( M_ARENA_MAX, 1 );
+#endif
+
+    QVERIFY( this->settings.isValid());
+    QVERIFY( this->dir.isValid());
+
+    // both engines would start extracting icons after the scan, only the listing is measured
+    QSettings::setDefaultFormat( QSettings::IniFormat );
+    QSettings::setPath( QSettings::IniFormat, QSettings::UserScope, this->settings.path());
+    QSettings().setValue( "cache/prefetch", false );
+
+    for ( int y = 0; y < Files; y++ ) {
+        QFile file( this->dir.filePath( QString( "document %1.txt" ).arg( y )));
+        QVERIFY( file.open( QIODevice::WriteOnly ));
+        file.write( QByteArray( y % 64, 'x' ));
+    }
+
+    for ( int y = 0; y < Folders; y++ )
+        QVERIFY( QDir( this->dir.path()).mkdir( QString( "folder %1" ).arg( y )));
+}
+
+/**
+ * @brief DirectoryIndexTest::open
+ * @param engine
+ * @return a new source listing the test folder
+ */
+DesktopItemSource *DirectoryIndexTest::open( Engine engine ) const {
+    if ( engine == Index )
+        return new DirectoryIndex( this->dir.path());
+
+    return new FileSystemModel( this->dir.path());
+}
+
+/**
+ * @brief DirectoryIndexTest::waitForRows runs the event loop until the source lists count rows
+ * @param source
+ * @param count
+ * @return false on timeout
+ */
+bool DirectoryIndexTest::waitForRows( DesktopItemSource *source, int count ) {
+    QAbstractItemModel *model( source->model());
+    if ( model->rowCount( source->rootIndex()) >= count )
+        return true;
+
+    // woken by the model itself, polling would add its interval to every measurement
+    QEventLoop loop;
+    auto check = [ model, source, count, &loop ]() {
+        if ( model->rowCount( source->rootIndex()) >= count )
+            loop.quit();
+    };
+    QAbstractItemModel::connect( model, &QAbstractItemModel::rowsInserted, &loop, check );
+    QAbstractItemModel::connect( model, &QAbstractItemModel::modelReset, &loop, check );
+    QTimer::singleShot( 30000, &loop, &QEventLoop::quit );
+    loop.exec();
+
+    return model->rowCount( source->rootIndex()) >= count;
+}
+
+/**
+ * @brief DirectoryIndexTest::heapInUse
+ * @return bytes allocated and not yet freed, -1 where the allocator does not tell
+ */
+qint64 DirectoryIndexTest::heapInUse() {
+#if defined( __GLIBC__ ) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 33 ))
+    const struct mallinfo2 info( mallinfo2());
+    return static_cast<qint64>( info.uordblks + info.hblkhd );
+#elif defined( __GLIBC__ )
+    const struct mallinfo info( mallinfo());
+    return static_cast<qint64>( static_cast<unsigned int>( info.uordblks )) + static_cast<unsigned int>( info.hblkhd );
+#else
+    return -1;
+#endif
+}
+
+/**
+ * @brief DirectoryIndexTest::sameEntries checks that both engines list the same paths, sizes and times
+ */
+void DirectoryIndexTest::sameEntries() {
+    QScopedPointer<DesktopItemSource> index( this->open( Index ));
+    QScopedPointer<DesktopItemSource> model( this->open( FileSystem ));
+    QVERIFY( DirectoryIndexTest::waitForRows( index.data(), Files + Folders ));
+    QVERIFY( DirectoryIndexTest::waitForRows( model.data(), Files + Folders ));
+
+    // folder sizes are reported differently, the rest must match
+    auto listing = []( DesktopItemSource *source ) {
+        QStringList entries;
+        for ( int y = 0; y < source->model()->rowCount( source->rootIndex()); y++ ) {
+            const DesktopItem item( source->partialItem( y ));
+            entries << QString( "%1 %2 %3" ).arg( item.path ).arg( item.path.endsWith( ".txt" ) ? item.size : 0 ).arg( item.lastModified.toMSecsSinceEpoch());
+        }
+        entries.sort();
+        return entries;
+    };
+
+    QCOMPARE( listing( index.data()), listing( model.data()));
+}
+
+/**
+ * @brief DirectoryIndexTest::memory_data
+ */
+void DirectoryIndexTest::memory_data() {
+    QTest::addColumn<Engine>( "engine" );
+
+    QTest::newRow( "index" ) << Index;
+    QTest::newRow( "filesystemmodel" ) << FileSystem;
+}
+
+/**
+ * @brief DirectoryIndexTest::memory reports the heap held by a loaded listing
+ */
+void DirectoryIndexTest::memory() {
+    QFETCH( Engine, engine );
+
+    if ( DirectoryIndexTest::heapInUse() < 0 )
+        QSKIP( "heap statistics are only read from glibc" );
+
+    // classification is shared by both engines and kept apart from the listing
+    MimeCache::instance()->wait();
+    MimeCache::instance()->clear();
+    const qint64 before = DirectoryIndexTest::heapInUse();
+
+    QScopedPointer<DesktopItemSource> source( this->open( engine ));
+    QVERIFY( DirectoryIndexTest::waitForRows( source.data(), Files + Folders ));
+    MimeCache::instance()->wait();
+    MimeCache::instance()->clear();
+
+    QTest::setBenchmarkResult( DirectoryIndexTest::heapInUse() - before, QTest::BytesAllocated );
+}
+
+/**
+ * @brief DirectoryIndexTest::scan_data
+ */
+void DirectoryIndexTest::scan_data() {
+    this->memory_data();
+}
+
+/**
+ * @brief DirectoryIndexTest::scan benchmarks listing the folder from scratch
+ */
+void DirectoryIndexTest::scan() {
+    QFETCH( Engine, engine );
+
+    QBENCHMARK {
+        QScopedPointer<DesktopItemSource> source( this->open( engine ));
+        QVERIFY( DirectoryIndexTest::waitForRows( source.data(), Files + Folders ));
+    }
+
+    MimeCache::instance()->wait();
+}
+
+QTEST_MAIN( DirectoryIndexTest )
+
+#include "tst_directoryindex.moc"
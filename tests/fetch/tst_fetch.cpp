@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "multidirmodel.h"
+#include "sortmodel.h"
+#include "syntheticsource.h"
+#include <QSignalSpy>
+#include <QtTest>
+
+/**
+ * @brief The FetchTest class checks chunked population and measures time to the first screenful
+ */
+class FetchTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void chunks();
+    void appendAfterFetch();
+    void firstPaint_data();
+    void firstPaint();
+
+private:
+    SyntheticSource *source = nullptr;
+};
+
+/*
+ * a desktop used as a drop folder
+ */
+static constexpr const int Items = 50000;
+
+/**
+ * @brief FetchTest::initTestCase
+ */
+void FetchTest::initTestCase() {
+    this->source = new SyntheticSource( Items, this );
+}
+
+/**
+ * @brief FetchTest::chunks checks that rows appear a chunk at a time until all are fetched
+ */
+void FetchTest::chunks() {
+    MultiDirModel model;
+    model.add( this->source );
+
+    const int chunk = model.rowCount();
+    QVERIFY( chunk > 0 && chunk < Items );
+    QVERIFY( model.canFetchMore( QModelIndex()));
+
+    QSignalSpy inserted( &model, &MultiDirModel::rowsInserted );
+    model.fetchMore( QModelIndex());
+    QCOMPARE( model.rowCount(), chunk * 2 );
+    QCOMPARE( inserted.count(), 1 );
+    QCOMPARE( inserted.first().at( 1 ).toInt(), chunk );
+    QCOMPARE( inserted.first().at( 2 ).toInt(), chunk * 2 - 1 );
+
+    while ( model.canFetchMore( QModelIndex()))
+        model.fetchMore( QModelIndex());
+    QCOMPARE( model.rowCount(), Items );
+    QCOMPARE( model.fileName( model.index( Items - 1, 0 )), SyntheticSource::make( Items - 1 ).name );
+}
+
+/**
+ * @brief FetchTest::appendAfterFetch checks that a large batch appended to a fetched model is shown a chunk at a time
+ */
+void FetchTest::appendAfterFetch() {
+    SyntheticSource first( 10 );
+    MultiDirModel model;
+    model.add( &first );
+    QCOMPARE( model.rowCount(), 10 );
+
+    SyntheticSource second( Items );
+    model.add( &second );
+    QVERIFY( model.rowCount() > 10 && model.rowCount() < 10 + Items );
+    QVERIFY( model.canFetchMore( QModelIndex()));
+}
+
+/**
+ * @brief FetchTest::firstPaint_data
+ */
+void FetchTest::firstPaint_data() {
+    QTest::addColumn<bool>( "chunked" );
+
+    QTest::newRow( "chunked" ) << true;
+    QTest::newRow( "complete" ) << false;
+}
+
+/**
+ * @brief FetchTest::firstPaint benchmarks adding a large folder until the sorted proxy can serve the first screenful
+ *
+ * The complete row pulls every row up front, as reset() did before rows were fetched on demand.
+ */
+void FetchTest::firstPaint() {
+    QFETCH( bool, chunked );
+
+    QBENCHMARK {
+        MultiDirModel model;
+        model.add( this->source );
+
+        if ( !chunked ) {
+            while ( model.canFetchMore( QModelIndex()))
+                model.fetchMore( QModelIndex());
+        }
+
+        // names are compared directly, the snapshot is not built yet
+        SortModel sortModel;
+        sortModel.setSourceModel( &model );
+        sortModel.sort( 0 );
+
+        QVERIFY( sortModel.rowCount() > 0 );
+        QVERIFY( !sortModel.data( sortModel.index( 0, 0 )).toString().isEmpty());
+    }
+}
+
+QTEST_GUILESS_MAIN( FetchTest )
+
+#include "tst_fetch.moc"
@@ -0,0 +1,26 @@
+QT       += core gui concurrent testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_filter
+
+INCLUDEPATH += ../.. ../shared
+
+SOURCES += \
+    ../../itemsnapshot.cpp \
+    ../../multidirmodel.cpp \
+    ../../sortmodel.cpp \
+    ../../trigramindex.cpp \
+    ../../updatescheduler.cpp \
+    ../shared/syntheticsource.cpp \
+    tst_filter.cpp
+
+HEADERS += \
+    ../../desktopitemsource.h \
+    ../../itemsnapshot.h \
+    ../../multidirmodel.h \
+    ../../sortmodel.h \
+    ../../trigramindex.h \
+    ../../updatescheduler.h \
+    ../shared/syntheticsource.h
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "multidirmodel.h"
+#include "sortmodel.h"
+#include "syntheticsource.h"
+#include <QRegularExpression>
+#include <QtTest>
+
+/**
+ * @brief The ScanSortModel class matches a regular expression against every row on each keystroke
+ */
+class ScanSortModel : public SortModel {
+    Q_OBJECT
+
+public:
+    void setPattern( const QString &text ) {
+        this->expression = QRegularExpression( QRegularExpression::escape( text ), QRegularExpression::CaseInsensitiveOption );
+        this->invalidateFilter();
+    }
+
+protected:
+    bool filterAcceptsRow( int sourceRow, const QModelIndex &sourceParent ) const override {
+        return this->expression.match( this->sourceModel()->index( sourceRow, 0, sourceParent ).data().toString()).hasMatch();
+    }
+
+private:
+    QRegularExpression expression;
+};
+
+/**
+ * @brief The FilterTest class checks type-to-filter results and measures the time per keystroke
+ */
+class FilterTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void matches_data();
+    void matches();
+    void newFile();
+    void keystroke_data();
+    void keystroke();
+
+private:
+    static QStringList names( const QAbstractItemModel &model );
+    SyntheticSource *source = nullptr;
+    MultiDirModel *model = nullptr;
+};
+
+/*
+ * desktop size for the keystroke benchmark
+ */
+static constexpr const int Items = 50000;
+
+/**
+ * @brief FilterTest::initTestCase
+ */
+void FilterTest::initTestCase() {
+    this->source = new SyntheticSource( Items, this );
+    this->model = new MultiDirModel( this );
+    this->model->add( this->source );
+    QVERIFY( SyntheticSource::settle( this->model ));
+}
+
+/**
+ * @brief FilterTest::names
+ * @param model
+ * @return sorted names of all rows
+ */
+QStringList FilterTest::names( const QAbstractItemModel &model ) {
+    QStringList names;
+    for ( int y = 0; y < model.rowCount(); y++ )
+        names << model.index( y, 0 ).data().toString();
+
+    names.sort();
+    return names;
+}
+
+/**
+ * @brief FilterTest::matches_data
+ */
+void FilterTest::matches_data() {
+    QTest::addColumn<QString>( "text" );
+
+    QTest::newRow( "one letter" ) << "r";
+    QTest::newRow( "two letters" ) << "Re";
+    QTest::newRow( "trigram" ) << "REP";
+    QTest::newRow( "word" ) << "report 1";
+    QTest::newRow( "digits" ) << "4711";
+    QTest::newRow( "accented" ) << "résumé";
+    QTest::newRow( "folded" ) << "ÜBER";
+    QTest::newRow( "across words" ) << "t 12";
+    QTest::newRow( "none" ) << "qqqq";
+}
+
+/**
+ * @brief FilterTest::matches compares the filtered rows with a case folded search over all names
+ */
+void FilterTest::matches() {
+    QFETCH( QString, text );
+
+    SortModel sortModel;
+    sortModel.setSourceModel( this->model );
+    sortModel.resort( SortModel::Name );
+    sortModel.setFilterText( text );
+
+    QStringList expected;
+    for ( int y = 0; y < this->model->rowCount(); y++ ) {
+        const QString name( this->model->fileName( this->model->index( y, 0 )));
+        if ( name.toCaseFolded().contains( text.toCaseFolded()))
+            expected << name;
+    }
+    expected.sort();
+
+    QCOMPARE( FilterTest::names( sortModel ), expected );
+}
+
+/**
+ * @brief FilterTest::newFile checks that a file added while filtering is tested as it arrives
+ */
+void FilterTest::newFile() {
+    SyntheticSource source( 100 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.setFilterText( "quarterly" );
+    QCOMPARE( sortModel.rowCount(), 0 );
+
+    DesktopItem item( SyntheticSource::make( 100 ));
+    item.name = "Quarterly figures.xlsx";
+    source.insert( 0, item );
+    source.insert( 1, SyntheticSource::make( 101 ));
+
+    QCOMPARE( sortModel.rowCount(), 1 );
+    QCOMPARE( sortModel.index( 0, 0 ).data().toString(), item.name );
+}
+
+/**
+ * @brief FilterTest::keystroke_data
+ */
+void FilterTest::keystroke_data() {
+    QTest::addColumn<QString>( "text" );
+    QTest::addColumn<bool>( "indexed" );
+
+    for ( const QString &text : QStringList() << "r" << "re" << "rep" << "repo" << "report 1" ) {
+        QTest::addRow( "trigram \"%s\"", qPrintable( text )) << text << true;
+        QTest::addRow( "scan \"%s\"", qPrintable( text )) << text << false;
+    }
+}
+
+/**
+ * @brief FilterTest::keystroke benchmarks filtering a sorted desktop for the text typed so far
+ */
+void FilterTest::keystroke() {
+    QFETCH( QString, text );
+    QFETCH( bool, indexed );
+
+    SortModel sortModel;
+    ScanSortModel scanModel;
+    sortModel.setSourceModel( this->model );
+    scanModel.setSourceModel( this->model );
+    sortModel.resort( SortModel::Name );
+    scanModel.resort( SortModel::Name );
+
+    // the same text is ignored, alternating case filters again with the same result
+    int pass = 0;
+    int shown = 0;
+    QBENCHMARK {
+        const QString typed( pass++ % 2 ? text.toUpper() : text );
+        if ( indexed ) {
+            sortModel.setFilterText( typed );
+            shown += sortModel.rowCount();
+        } else {
+            scanModel.setPattern( typed );
+            shown += scanModel.rowCount();
+        }
+    }
+    QVERIFY( shown > 0 );
+}
+
+QTEST_GUILESS_MAIN( FilterTest )
+
+#include "tst_filter.moc"
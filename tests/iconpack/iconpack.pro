@@ -0,0 +1,15 @@
+QT       += core gui concurrent testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_iconpack
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../iconpack.cpp \
+    tst_iconpack.cpp
+
+HEADERS += \
+    ../../iconpack.h
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "iconpack.h"
+#include <QDir>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/**
+ * @brief The IconPackTest class compares the icon pack with the per-file PNG cache it replaced
+ */
+class IconPackTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void roundTrip();
+    void lookup_data();
+    void lookup();
+    void store_data();
+    void store();
+
+private:
+    static QString pngName( const QString &directory, const QString &key );
+    QVector<QImage> images;
+    QStringList keys;
+};
+
+/*
+ * one desktop worth of 64 pixel icons
+ */
+static constexpr const int Icons = 1000;
+static constexpr const int Size = 64;
+
+/**
+ * @brief IconPackTest::initTestCase makes noisy icons, so that PNG compression does not flatter the old path
+ */
+void IconPackTest::initTestCase() {
+    QRandomGenerator random( 78 );
+
+    for ( int y = 0; y < Icons; y++ ) {
+        QImage image( Size, Size, QImage::Format_ARGB32_Premultiplied );
+        image.fill( Qt::transparent );
+        for ( int row = 8; row < Size - 8; row++ ) {
+            quint32 *line = reinterpret_cast<quint32 *>( image.scanLine( row ));
+            for ( int x = 8; x < Size - 8; x++ )
+                line[x] = 0xff000000u | ( random.generate() & 0x003f3f3fu ) | ( static_cast<quint32>( y ) * 0x010203u & 0x00c0c0c0u );
+        }
+
+        this->images << image;
+        this->keys << QString( "/home/user/Desktop/file %1.txt" ).arg( y );
+    }
+}
+
+/**
+ * @brief IconPackTest::pngName is the file name the per-file cache used
+ * @param directory
+ * @param key
+ * @return
+ */
+QString IconPackTest::pngName( const QString &directory, const QString &key ) {
+    return QString( "%1/%2_%3.png" ).arg( directory ).arg( QString( key.toUtf8().toBase64())).arg( Size );
+}
+
+/**
+ * @brief IconPackTest::roundTrip checks that a reopened pack returns every image unchanged
+ */
+void IconPackTest::roundTrip() {
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid());
+
+    {
+        IconPack pack( dir.filePath( "icons.pack" ));
+        QVERIFY( pack.isOpen());
+        for ( int y = 0; y < Icons; y++ )
+            pack.insert( this->keys.at( y ), this->images.at( y ), static_cast<quint64>( y ));
+        pack.flush();
+    }
+
+    const IconPack pack( dir.filePath( "icons.pack" ));
+    QCOMPARE( pack.count(), Icons );
+    for ( int y = 0; y < Icons; y++ ) {
+        QCOMPARE( pack.image( this->keys.at( y ), static_cast<quint64>( y )), this->images.at( y ));
+        QVERIFY( pack.image( this->keys.at( y ), static_cast<quint64>( y ) + 1 ).isNull());
+    }
+}
+
+/**
+ * @brief IconPackTest::lookup_data
+ */
+void IconPackTest::lookup_data() {
+    QTest::addColumn<bool>( "packed" );
+
+    QTest::newRow( "pack" ) << true;
+    QTest::newRow( "png" ) << false;
+}
+
+/**
+ * @brief IconPackTest::lookup benchmarks cache hits for every icon after a restart
+ */
+void IconPackTest::lookup() {
+    QFETCH( bool, packed );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid());
+
+    if ( packed ) {
+        {
+            IconPack pack( dir.filePath( "icons.pack" ));
+            for ( int y = 0; y < Icons; y++ )
+                pack.insert( this->keys.at( y ), this->images.at( y ));
+        }
+
+        // reopened, so that hits come from the mapping and not from the append buffer
+        const IconPack pack( dir.filePath( "icons.pack" ));
+        QBENCHMARK {
+            for ( const QString &key : qAsConst( this->keys ))
+                QVERIFY( !pack.image( key ).isNull());
+        }
+    } else {
+        for ( int y = 0; y < Icons; y++ )
+            QVERIFY( this->images.at( y ).save( IconPackTest::pngName( dir.path(), this->keys.at( y ))));
+
+        // the per-file cache decoded through QPixmap, the decode is the same without a display
+        QBENCHMARK {
+            for ( const QString &key : qAsConst( this->keys ))
+                QVERIFY( !QImage( IconPackTest::pngName( dir.path(), key )).isNull());
+        }
+    }
+}
+
+/**
+ * @brief IconPackTest::store_data
+ */
+void IconPackTest::store_data() {
+    this->lookup_data();
+}
+
+/**
+ * @brief IconPackTest::store benchmarks writing every icon to an empty cache
+ */
+void IconPackTest::store() {
+    QFETCH( bool, packed );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid());
+
+    int pass = 0;
+    QBENCHMARK {
+        const QString directory( dir.filePath( QString::number( pass++ )));
+        QVERIFY( QDir().mkpath( directory ));
+
+        if ( packed ) {
+            IconPack pack( directory + "/icons.pack" );
+            for ( int y = 0; y < Icons; y++ )
+                pack.insert( this->keys.at( y ), this->images.at( y ));
+            pack.flush();
+        } else {
+            for ( int y = 0; y < Icons; y++ )
+                QVERIFY( this->images.at( y ).save( IconPackTest::pngName( directory, this->keys.at( y ))));
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN( IconPackTest )
+
+#include "tst_iconpack.moc"
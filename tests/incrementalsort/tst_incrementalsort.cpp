@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "multidirmodel.h"
+#include "sortmodel.h"
+#include "syntheticsource.h"
+#include <QCollator>
+#include <QSignalSpy>
+#include <QtTest>
+
+/**
+ * @brief The IncrementalSortTest class measures keeping a sorted view in order while single items change
+ */
+class IncrementalSortTest : public QObject {
+    Q_OBJECT
+
+public:
+    enum Change {
+        Insert,
+        Rename
+    };
+    Q_ENUM( Change )
+
+private slots:
+    void insertInPlace();
+    void renameInPlace();
+    void change_data();
+    void change();
+
+private:
+    static void verifyOrder( const SortModel &sortModel );
+};
+
+/*
+ * desktop size for the latency benchmark
+ */
+static constexpr const int Items = 10000;
+
+/**
+ * @brief IncrementalSortTest::verifyOrder checks that every row collates after the one before it
+ * @param sortModel
+ */
+void IncrementalSortTest::verifyOrder( const SortModel &sortModel ) {
+    QCollator collator;
+    collator.setNumericMode( sortModel.numericMode());
+
+    for ( int y = 1; y < sortModel.rowCount(); y++ ) {
+        const QString previous( sortModel.index( y - 1, 0 ).data().toString());
+        const QString current( sortModel.index( y, 0 ).data().toString());
+        QVERIFY2( collator.compare( previous, current ) <= 0, qPrintable( previous + " > " + current ));
+    }
+}
+
+/**
+ * @brief IncrementalSortTest::insertInPlace checks that new files are placed without a layout change
+ */
+void IncrementalSortTest::insertInPlace() {
+    SyntheticSource source( 1000 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.resort( SortModel::Name );
+
+    QSignalSpy inserted( &sortModel, &SortModel::rowsInserted );
+    QSignalSpy layoutChanged( &sortModel, &SortModel::layoutChanged );
+    for ( int y = 0; y < 50; y++ )
+        source.insert(( y * 37 ) % source.rowCount(), SyntheticSource::make( 1000 + y ));
+
+    QCOMPARE( inserted.count(), 50 );
+    QCOMPARE( layoutChanged.count(), 0 );
+    QCOMPARE( sortModel.rowCount(), 1050 );
+    IncrementalSortTest::verifyOrder( sortModel );
+}
+
+/**
+ * @brief IncrementalSortTest::renameInPlace checks that renamed files move to their new place
+ */
+void IncrementalSortTest::renameInPlace() {
+    SyntheticSource source( 1000 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.resort( SortModel::Name );
+
+    source.rename( 10, "aaa first.txt" );
+    source.rename( 20, "zzz last.txt" );
+    source.rename( 30, "Notes 31.txt" );
+
+    QCOMPARE( sortModel.index( 0, 0 ).data().toString(), QString( "aaa first.txt" ));
+    QCOMPARE( sortModel.index( sortModel.rowCount() - 1, 0 ).data().toString(), QString( "zzz last.txt" ));
+    IncrementalSortTest::verifyOrder( sortModel );
+}
+
+/**
+ * @brief IncrementalSortTest::change_data
+ */
+void IncrementalSortTest::change_data() {
+    QTest::addColumn<Change>( "change" );
+    QTest::addColumn<bool>( "incremental" );
+
+    QTest::newRow( "insert incremental" ) << Insert << true;
+    QTest::newRow( "insert full" ) << Insert << false;
+    QTest::newRow( "rename incremental" ) << Rename << true;
+    QTest::newRow( "rename full" ) << Rename << false;
+}
+
+/**
+ * @brief IncrementalSortTest::change benchmarks one change on a sorted desktop until the view can show it
+ *
+ * The full rows sort everything again after each change, as the proxy did before.
+ */
+void IncrementalSortTest::change() {
+    QFETCH( Change, change );
+    QFETCH( bool, incremental );
+
+    SyntheticSource source( Items );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.resort( SortModel::Name );
+
+    int seed = Items;
+    QBENCHMARK {
+        if ( change == Insert )
+            source.insert( seed % source.rowCount(), SyntheticSource::make( seed ));
+        else
+            source.rename( seed % source.rowCount(), QString( "renamed %1.txt" ).arg( seed ));
+        seed++;
+
+        // an invalidated proxy sorts when it is next asked for a row, so ask
+        if ( !incremental )
+            sortModel.invalidate();
+        QVERIFY( sortModel.index( 0, 0 ).isValid());
+    }
+}
+
+QTEST_GUILESS_MAIN( IncrementalSortTest )
+
+#include "tst_incrementalsort.moc"
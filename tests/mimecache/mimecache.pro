@@ -0,0 +1,17 @@
+QT       += core concurrent testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_mimecache
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../fileidentity.cpp \
+    ../../mimecache.cpp \
+    tst_mimecache.cpp
+
+HEADERS += \
+    ../../fileidentity.h \
+    ../../mimecache.h
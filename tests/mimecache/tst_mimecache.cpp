@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "mimecache.h"
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+/**
+ * @brief The MimeCacheTest class classifies a folder of mixed files
+ */
+class MimeCacheTest : public QObject {
+    Q_OBJECT
+
+public:
+    enum Mode {
+        Database,
+        Cold,
+        Batch,
+        Warm
+    };
+    Q_ENUM( Mode )
+
+private slots:
+    void initTestCase();
+    void batchMatchesSingle();
+    void changedFile();
+    void classify_data();
+    void classify();
+
+private:
+    QTemporaryDir dir;
+    QFileInfoList files;
+};
+
+/*
+ * a typical drop folder, some extensions are ambiguous and some files have none
+ */
+static constexpr const int Files = 10000;
+
+/**
+ * @brief MimeCacheTest::initTestCase writes small files with real magic numbers
+ */
+void MimeCacheTest::initTestCase() {
+    using Sample = QPair<QString, QByteArray>;
+
+    QVERIFY( this->dir.isValid());
+
+    const QVector<Sample> samples( QVector<Sample>()
+                                   << Sample( ".txt", "plain text\n" )
+                                   << Sample( ".pdf", "%PDF-1.4\n" )
+                                   << Sample( ".png", QByteArray::fromHex( "89504e470d0a1a0a" ))
+                                   << Sample( ".jpg", QByteArray::fromHex( "ffd8ffe000104a464946" ))
+                                   << Sample( ".zip", QByteArray::fromHex( "504b0304" ))
+                                   << Sample( ".tar.gz", QByteArray::fromHex( "1f8b0800" ))
+                                   << Sample( ".cpp", "int main() {}\n" )
+                                   << Sample( ".h", "#pragma once\n" )
+                                   << Sample( ".desktop", "[Desktop Entry]\n" )
+                                   << Sample( ".lnk", QByteArray::fromHex( "4c000000" ))
+                                   << Sample( ".bak", "backup\n" )
+                                   << Sample( "", "#!/bin/sh\n" ));
+
+    for ( int y = 0; y < Files; y++ ) {
+        const Sample &sample( samples.at( y % samples.count()));
+        QFile file( this->dir.filePath( QString( "file %1%2" ).arg( y ).arg( sample.first )));
+        QVERIFY( file.open( QIODevice::WriteOnly ));
+        file.write( sample.second );
+    }
+
+    // listings come with their metadata already read, so does this
+    this->files = QDir( this->dir.path()).entryInfoList( QDir::Files | QDir::NoDotAndDotDot );
+    QCOMPARE( this->files.count(), Files );
+}
+
+/**
+ * @brief MimeCacheTest::batchMatchesSingle checks that worker classification gives the same names as direct calls
+ */
+void MimeCacheTest::batchMatchesSingle() {
+    MimeCache batch;
+    batch.classify( this->files );
+    batch.wait();
+    QCOMPARE( batch.count(), Files );
+
+    MimeCache single;
+    for ( const QFileInfo &info : qAsConst( this->files ))
+        QCOMPARE( batch.name( info ), single.name( info ));
+}
+
+/**
+ * @brief MimeCacheTest::changedFile checks that a rewritten file is classified again
+ */
+void MimeCacheTest::changedFile() {
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid());
+
+    const QString path( dir.filePath( "document" ));
+    QFile file( path );
+    QVERIFY( file.open( QIODevice::WriteOnly ));
+    file.write( "plain text\n" );
+    file.close();
+
+    MimeCache cache;
+    QCOMPARE( cache.name( QFileInfo( path ), MimeCache::Content ), QString( "text/plain" ));
+
+    QVERIFY( file.open( QIODevice::WriteOnly ));
+    file.write( "%PDF-1.4\n%\xe2\xe3\xcf\xd3\n" );
+    file.close();
+
+    QCOMPARE( cache.name( QFileInfo( path ), MimeCache::Content ), QString( "application/pdf" ));
+    QCOMPARE( cache.count(), 1 );
+}
+
+/**
+ * @brief MimeCacheTest::classify_data
+ */
+void MimeCacheTest::classify_data() {
+    QTest::addColumn<Mode>( "mode" );
+
+    QTest::newRow( "database" ) << Database;
+    QTest::newRow( "cold" ) << Cold;
+    QTest::newRow( "batch" ) << Batch;
+    QTest::newRow( "warm" ) << Warm;
+}
+
+/**
+ * @brief MimeCacheTest::classify benchmarks naming every file against the content sniffing the models did before
+ */
+void MimeCacheTest::classify() {
+    QFETCH( Mode, mode );
+
+    MimeCache warm;
+    if ( mode == Warm ) {
+        for ( const QFileInfo &info : qAsConst( this->files ))
+            warm.name( info );
+    }
+
+    int named = 0;
+    QBENCHMARK {
+        if ( mode == Database ) {
+            // a fresh database and a content match for every file
+            for ( const QFileInfo &info : qAsConst( this->files ))
+                named += !QMimeDatabase().mimeTypeForFile( info.absoluteFilePath(), QMimeDatabase::MatchContent ).name().isEmpty();
+        } else if ( mode == Batch ) {
+            MimeCache cache;
+            cache.classify( this->files );
+            cache.wait();
+            named += cache.count();
+        } else {
+            MimeCache cold;
+            MimeCache &cache( mode == Warm ? warm : cold );
+            for ( const QFileInfo &info : qAsConst( this->files ))
+                named += !cache.name( info ).isEmpty();
+        }
+    }
+    QVERIFY( named >= Files );
+}
+
+QTEST_APPLESS_MAIN( MimeCacheTest )
+
+#include "tst_mimecache.moc"
@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "multidirmodel.h"
+#include "sortmodel.h"
+#include "syntheticsource.h"
+#include <QSignalSpy>
+#include <QtTest>
+
+/**
+ * @brief The MultiDirModelTest class checks row forwarding and measures churn on a populated desktop
+ */
+class MultiDirModelTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void forwardInsert();
+    void forwardRemove();
+    void forwardRename();
+    void secondSource();
+    void churn_data();
+    void churn();
+};
+
+/*
+ * desktop size for the churn benchmark
+ */
+static constexpr const int Items = 5000;
+
+/**
+ * @brief MultiDirModelTest::forwardInsert checks that a new file is one inserted row, not a reset
+ */
+void MultiDirModelTest::forwardInsert() {
+    SyntheticSource source( 100 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    QSignalSpy inserted( &model, &MultiDirModel::rowsInserted );
+    QSignalSpy reset( &model, &MultiDirModel::modelReset );
+    const DesktopItem item( SyntheticSource::make( 1000 ));
+    source.insert( 50, item );
+
+    QCOMPARE( inserted.count(), 1 );
+    QCOMPARE( inserted.first().at( 1 ).toInt(), 50 );
+    QCOMPARE( reset.count(), 0 );
+    QCOMPARE( model.rowCount(), 101 );
+    QVERIFY( model.snapshot() != nullptr );
+    QCOMPARE( model.fileName( model.index( 50, 0 )), item.name );
+    QCOMPARE( model.fileName( model.index( 51, 0 )), SyntheticSource::make( 50 ).name );
+}
+
+/**
+ * @brief MultiDirModelTest::forwardRemove checks that a deleted file is one removed row
+ */
+void MultiDirModelTest::forwardRemove() {
+    SyntheticSource source( 100 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    QSignalSpy removed( &model, &MultiDirModel::rowsRemoved );
+    QSignalSpy reset( &model, &MultiDirModel::modelReset );
+    source.remove( 10 );
+
+    QCOMPARE( removed.count(), 1 );
+    QCOMPARE( removed.first().at( 1 ).toInt(), 10 );
+    QCOMPARE( reset.count(), 0 );
+    QCOMPARE( model.rowCount(), 99 );
+    QVERIFY( model.snapshot() != nullptr );
+    QCOMPARE( model.fileName( model.index( 10, 0 )), SyntheticSource::make( 11 ).name );
+}
+
+/**
+ * @brief MultiDirModelTest::forwardRename checks that a renamed file updates its row and the snapshot
+ */
+void MultiDirModelTest::forwardRename() {
+    SyntheticSource source( 100 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    QSignalSpy changed( &model, &MultiDirModel::dataChanged );
+    source.rename( 20, "renamed.txt" );
+
+    QCOMPARE( changed.count(), 1 );
+    QCOMPARE( changed.first().at( 0 ).toModelIndex().row(), 20 );
+    QVERIFY( model.snapshot() != nullptr );
+    QCOMPARE( model.fileName( model.index( 20, 0 )), QString( "renamed.txt" ));
+}
+
+/**
+ * @brief MultiDirModelTest::secondSource checks that rows of a later source are shifted by the first one
+ */
+void MultiDirModelTest::secondSource() {
+    SyntheticSource first( 10 );
+    SyntheticSource second( 5 );
+    MultiDirModel model;
+    model.add( &first );
+    model.add( &second );
+    QVERIFY( SyntheticSource::settle( &model ));
+    QCOMPARE( model.rowCount(), 15 );
+
+    QSignalSpy inserted( &model, &MultiDirModel::rowsInserted );
+    first.insert( 0, SyntheticSource::make( 1000 ));
+    second.insert( 1, SyntheticSource::make( 2000 ));
+
+    QCOMPARE( inserted.count(), 2 );
+    QCOMPARE( inserted.at( 1 ).at( 1 ).toInt(), 12 );
+    QCOMPARE( model.fileName( model.index( 12, 0 )), SyntheticSource::make( 2000 ).name );
+    QCOMPARE( model.fileName( model.index( 11, 0 )), SyntheticSource::make( 0 ).name );
+}
+
+/**
+ * @brief MultiDirModelTest::churn_data
+ */
+void MultiDirModelTest::churn_data() {
+    QTest::addColumn<bool>( "resets" );
+
+    QTest::newRow( "forwarded" ) << false;
+    QTest::newRow( "reset" ) << true;
+}
+
+/**
+ * @brief MultiDirModelTest::churn benchmarks one new file on a sorted desktop until the models are settled again
+ *
+ * The reset row is what every directoryLoaded did before rows were forwarded.
+ */
+void MultiDirModelTest::churn() {
+    QFETCH( bool, resets );
+
+    SyntheticSource source( Items );
+    MultiDirModel model;
+    SortModel sortModel;
+    model.add( &source );
+    sortModel.setSourceModel( &model );
+    QVERIFY( SyntheticSource::settle( &model ));
+    sortModel.resort( SortModel::Name );
+
+    int seed = Items;
+    QBENCHMARK {
+        source.insert( seed % source.rowCount(), SyntheticSource::make( seed ));
+        seed++;
+
+        if ( resets )
+            model.reset();
+
+        QVERIFY( SyntheticSource::settle( &model ));
+    }
+    QCOMPARE( sortModel.rowCount(), source.rowCount());
+}
+
+QTEST_GUILESS_MAIN( MultiDirModelTest )
+
+#include "tst_multidirmodel.moc"
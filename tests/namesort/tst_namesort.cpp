@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "multidirmodel.h"
+#include "sortmodel.h"
+#include "syntheticsource.h"
+#include <QCollator>
+#include <QtTest>
+
+/**
+ * @brief The LocaleSortModel class collates both names on every comparison, as SortModel did
+ */
+class LocaleSortModel : public QSortFilterProxyModel {
+    Q_OBJECT
+
+protected:
+    bool lessThan( const QModelIndex &left, const QModelIndex &right ) const override {
+        const MultiDirModel *model( qobject_cast<const MultiDirModel *>( left.model()));
+        return QString::localeAwareCompare( model->fileName( left ), model->fileName( right )) < 0;
+    }
+};
+
+/**
+ * @brief The NameSortTest class measures sorting by name with collation keys
+ */
+class NameSortTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void collatedOrder();
+    void numericOrder_data();
+    void numericOrder();
+    void sort_data();
+    void sort();
+};
+
+/**
+ * @brief NameSortTest::collatedOrder checks that sorting by keys gives the order the collator gives
+ */
+void NameSortTest::collatedOrder() {
+    SyntheticSource source( 2000 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.setNumericMode( false );
+    sortModel.setSortMode( SortModel::Name );
+    sortModel.sort( 0 );
+
+    const QCollator collator;
+    for ( int y = 1; y < sortModel.rowCount(); y++ ) {
+        const QString previous( sortModel.index( y - 1, 0 ).data().toString());
+        const QString current( sortModel.index( y, 0 ).data().toString());
+        QVERIFY2( collator.compare( previous, current ) <= 0, qPrintable( previous + " > " + current ));
+    }
+}
+
+/**
+ * @brief NameSortTest::numericOrder_data
+ */
+void NameSortTest::numericOrder_data() {
+    QTest::addColumn<bool>( "numeric" );
+    QTest::addColumn<QStringList>( "sorted" );
+
+    QTest::newRow( "plain" ) << false << ( QStringList() << "file1.txt" << "file10.txt" << "file2.txt" );
+    QTest::newRow( "numeric" ) << true << ( QStringList() << "file1.txt" << "file2.txt" << "file10.txt" );
+}
+
+/**
+ * @brief NameSortTest::numericOrder checks digit runs with and without numeric mode
+ */
+void NameSortTest::numericOrder() {
+    QFETCH( bool, numeric );
+    QFETCH( QStringList, sorted );
+
+    SyntheticSource source;
+    for ( const QString &name : QStringList() << "file10.txt" << "file2.txt" << "file1.txt" ) {
+        DesktopItem item( SyntheticSource::make( 0 ));
+        item.name = name;
+        source.insert( source.rowCount(), item );
+    }
+
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.setNumericMode( numeric );
+    sortModel.resort( SortModel::Name );
+
+    QStringList names;
+    for ( int y = 0; y < sortModel.rowCount(); y++ )
+        names << sortModel.index( y, 0 ).data().toString();
+    QCOMPARE( names, sorted );
+}
+
+/**
+ * @brief NameSortTest::sort_data
+ */
+void NameSortTest::sort_data() {
+    QTest::addColumn<bool>( "keys" );
+    QTest::addColumn<int>( "count" );
+
+    for ( const int count : QVector<int>() << 1000 << 10000 << 50000 ) {
+        QTest::addRow( "keys %d", count ) << true << count;
+        QTest::addRow( "locale %d", count ) << false << count;
+    }
+}
+
+/**
+ * @brief NameSortTest::sort benchmarks a full sort by name with a new proxy, keys included
+ */
+void NameSortTest::sort() {
+    QFETCH( bool, keys );
+    QFETCH( int, count );
+
+    SyntheticSource source( count );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    // a new proxy every time, sort() does nothing if column and order are unchanged
+    QBENCHMARK {
+        if ( keys ) {
+            SortModel sortModel;
+            sortModel.setSourceModel( &model );
+            sortModel.setSortMode( SortModel::Name );
+            sortModel.sort( 0 );
+            QCOMPARE( sortModel.rowCount(), count );
+        } else {
+            LocaleSortModel localeModel;
+            localeModel.setSourceModel( &model );
+            localeModel.sort( 0 );
+            QCOMPARE( localeModel.rowCount(), count );
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN( NameSortTest )
+
+#include "tst_namesort.moc"
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "multidirmodel.h"
+#include "sortmodel.h"
+#include "syntheticsource.h"
+#include <QSignalSpy>
+#include <QtTest>
+
+/**
+ * @brief The ResortTest class compares SortModel::resort with the descending-then-ascending sort it replaced
+ */
+class ResortTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void sameOrder_data();
+    void sameOrder();
+    void resort_data();
+    void resort();
+
+private:
+    static void twoPass( SortModel *sortModel, SortModel::SortMode mode );
+    static QStringList keys( const SortModel &sortModel, SortModel::SortMode mode );
+};
+
+/**
+ * @brief ResortTest::twoPass sorts the way the "Sort by" menu did
+ * @param sortModel
+ * @param mode
+ */
+void ResortTest::twoPass( SortModel *sortModel, SortModel::SortMode mode ) {
+    sortModel->setSortMode( mode );
+    sortModel->sort( 0, Qt::DescendingOrder );
+    sortModel->sort( 0, Qt::AscendingOrder );
+}
+
+/**
+ * @brief ResortTest::keys
+ * @param sortModel
+ * @param mode
+ * @return the sorted values in proxy order, rows with equal values may come in any order
+ */
+QStringList ResortTest::keys( const SortModel &sortModel, SortModel::SortMode mode ) {
+    const MultiDirModel *model( qobject_cast<const MultiDirModel *>( sortModel.sourceModel()));
+
+    QStringList keys;
+    for ( int y = 0; y < sortModel.rowCount(); y++ ) {
+        const QModelIndex index( sortModel.mapToSource( sortModel.index( y, 0 )));
+        switch ( mode ) {
+        case SortModel::Name:
+            keys << model->fileName( index );
+            break;
+
+        case SortModel::Type:
+            keys << model->mimeTypeName( index );
+            break;
+
+        case SortModel::Size:
+            keys << QString::number( model->size( index ));
+            break;
+
+        case SortModel::Date:
+            keys << QString::number( model->lastModified( index ).toMSecsSinceEpoch());
+            break;
+
+        case SortModel::NoMode:
+            ;
+        }
+    }
+
+    return keys;
+}
+
+/**
+ * @brief ResortTest::sameOrder_data
+ */
+void ResortTest::sameOrder_data() {
+    QTest::addColumn<SortModel::SortMode>( "mode" );
+    QTest::addColumn<int>( "count" );
+
+    // both sides of the parallel threshold
+    for ( const int count : QVector<int>() << SortModel::ParallelRows / 4 << SortModel::ParallelRows * 3 ) {
+        QTest::addRow( "name %d", count ) << SortModel::Name << count;
+        QTest::addRow( "type %d", count ) << SortModel::Type << count;
+        QTest::addRow( "size %d", count ) << SortModel::Size << count;
+        QTest::addRow( "date %d", count ) << SortModel::Date << count;
+    }
+}
+
+/**
+ * @brief ResortTest::sameOrder checks that a single resort orders like two sorts and changes the layout once
+ */
+void ResortTest::sameOrder() {
+    QFETCH( SortModel::SortMode, mode );
+    QFETCH( int, count );
+
+    SyntheticSource source( count );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel reference;
+    reference.setSourceModel( &model );
+    ResortTest::twoPass( &reference, mode );
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.resort( SortModel::Name );
+
+    QSignalSpy layoutChanged( &sortModel, &SortModel::layoutChanged );
+    sortModel.resort( mode );
+    QCOMPARE( layoutChanged.count(), 1 );
+    QCOMPARE( ResortTest::keys( sortModel, mode ), ResortTest::keys( reference, mode ));
+}
+
+/**
+ * @brief ResortTest::resort_data
+ */
+void ResortTest::resort_data() {
+    QTest::addColumn<SortModel::SortMode>( "mode" );
+    QTest::addColumn<int>( "count" );
+    QTest::addColumn<bool>( "single" );
+
+    for ( const int count : QVector<int>() << 10000 << 50000 ) {
+        QTest::addRow( "name %d resort", count ) << SortModel::Name << count << true;
+        QTest::addRow( "name %d two pass", count ) << SortModel::Name << count << false;
+        QTest::addRow( "type %d resort", count ) << SortModel::Type << count << true;
+        QTest::addRow( "type %d two pass", count ) << SortModel::Type << count << false;
+        QTest::addRow( "size %d resort", count ) << SortModel::Size << count << true;
+        QTest::addRow( "size %d two pass", count ) << SortModel::Size << count << false;
+        QTest::addRow( "date %d resort", count ) << SortModel::Date << count << true;
+        QTest::addRow( "date %d two pass", count ) << SortModel::Date << count << false;
+    }
+}
+
+/**
+ * @brief ResortTest::resort benchmarks a "Sort by" click on a sorted view
+ */
+void ResortTest::resort() {
+    QFETCH( SortModel::SortMode, mode );
+    QFETCH( int, count );
+    QFETCH( bool, single );
+
+    SyntheticSource source( count );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.resort( SortModel::Name );
+
+    // an invalidated proxy sorts when it is next asked for a row, so ask
+    QBENCHMARK {
+        if ( single )
+            sortModel.resort( mode );
+        else
+            ResortTest::twoPass( &sortModel, mode );
+
+        QVERIFY( sortModel.index( 0, 0 ).isValid());
+    }
+}
+
+QTEST_GUILESS_MAIN( ResortTest )
+
+#include "tst_resort.moc"
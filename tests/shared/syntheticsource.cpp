@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "multidirmodel.h"
+#include "syntheticsource.h"
+#include <QRandomGenerator>
+#include <QTest>
+
+/**
+ * @brief SyntheticSource::SyntheticSource
+ * @param count
+ * @param parent
+ */
+SyntheticSource::SyntheticSource( int count, QObject *parent ) : QAbstractListModel( parent ) {
+    this->items.reserve( count );
+    for ( int y = 0; y < count; y++ )
+        this->items << SyntheticSource::make( y );
+}
+
+/**
+ * @brief SyntheticSource::make
+ * @param seed
+ * @return a file named like the ones found on real desktops, unique per seed
+ */
+DesktopItem SyntheticSource::make( int seed ) {
+    using Kind = QPair<QString, QString>;
+
+    static const QStringList prefixes( QStringList() << "Report " << "IMG_" << "file" << "Screenshot 2020-05-" << "Notes "
+                                       << "invoice-" << "Résumé " << "backup_" << "Project " << "photo" << "Übersicht " << "zeta" );
+    static const QVector<Kind> kinds( QVector<Kind>()
+                                      << Kind( ".txt", "text/plain" )
+                                      << Kind( ".pdf", "application/pdf" )
+                                      << Kind( ".jpg", "image/jpeg" )
+                                      << Kind( ".png", "image/png" )
+                                      << Kind( ".docx", "application/vnd.openxmlformats-officedocument.wordprocessingml.document" )
+                                      << Kind( ".zip", "application/zip" )
+                                      << Kind( ".lnk", "application/x-ms-shortcut" )
+                                      << Kind( "", "inode/directory" ));
+
+    QRandomGenerator random( static_cast<quint32>( seed ));
+    const Kind &kind( kinds.at( random.bounded( kinds.count())));
+    const QString fileName( prefixes.at( random.bounded( prefixes.count())) + QString::number( seed ) + kind.first );
+
+    DesktopItem item;
+    item.name = DesktopItem::displayName( fileName );
+    item.path = "/synthetic/Desktop/" + fileName;
+    item.size = kind.first.isEmpty() ? 0 : random.bounded( 1 << 24 );
+    item.lastModified = QDateTime::fromMSecsSinceEpoch( Q_INT64_C( 1577836800000 ) + random.bounded( 1 << 30 ) * Q_INT64_C( 10 ));
+    item.type = kind.second;
+    item.flags = Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsDragEnabled;
+    return item;
+}
+
+/**
+ * @brief SyntheticSource::settle fetches every row and waits for the snapshot
+ * @param model
+ * @return false if the snapshot was not built in time
+ */
+bool SyntheticSource::settle( MultiDirModel *model ) {
+    while ( model->canFetchMore( QModelIndex()))
+        model->fetchMore( QModelIndex());
+
+    return QTest::qWaitFor( [ model ]() { return model->snapshot() != nullptr; }, 30000 );
+}
+
+/**
+ * @brief SyntheticSource::rowCount
+ * @param parent
+ * @return
+ */
+int SyntheticSource::rowCount( const QModelIndex &parent ) const {
+    return parent.isValid() ? 0 : this->items.count();
+}
+
+/**
+ * @brief SyntheticSource::data
+ * @param index
+ * @param role
+ * @return
+ */
+QVariant SyntheticSource::data( const QModelIndex &index, int role ) const {
+    if ( !index.isValid() || index.row() >= this->items.count())
+        return QVariant();
+
+    if ( role == Qt::DisplayRole || role == Qt::EditRole )
+        return this->items.at( index.row()).name;
+
+    return QVariant();
+}
+
+/**
+ * @brief SyntheticSource::flags
+ * @param index
+ * @return
+ */
+Qt::ItemFlags SyntheticSource::flags( const QModelIndex &index ) const {
+    if ( !index.isValid() || index.row() >= this->items.count())
+        return Qt::NoItemFlags;
+
+    return this->items.at( index.row()).flags;
+}
+
+/**
+ * @brief SyntheticSource::insert
+ * @param row
+ * @param item
+ */
+void SyntheticSource::insert( int row, const DesktopItem &item ) {
+    this->beginInsertRows( QModelIndex(), row, row );
+    this->items.insert( row, item );
+    this->endInsertRows();
+}
+
+/**
+ * @brief SyntheticSource::remove
+ * @param row
+ */
+void SyntheticSource::remove( int row ) {
+    this->beginRemoveRows( QModelIndex(), row, row );
+    this->items.remove( row );
+    this->endRemoveRows();
+}
+
+/**
+ * @brief SyntheticSource::rename
+ * @param row
+ * @param name
+ */
+void SyntheticSource::rename( int row, const QString &name ) {
+    this->items[row].name = name;
+    this->items[row].path = "/synthetic/Desktop/" + name;
+
+    const QModelIndex index( this->index( row, 0 ));
+    emit this->dataChanged( index, index, QVector<int>() << Qt::DisplayRole );
+}
+
+/**
+ * @brief SyntheticSource::reset replaces every item, like a directory that was listed again
+ * @param count
+ */
+void SyntheticSource::reset( int count ) {
+    this->beginResetModel();
+    this->items.clear();
+    for ( int y = 0; y < count; y++ )
+        this->items << SyntheticSource::make( y );
+    this->endResetModel();
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include "desktopitemsource.h"
+#include <QAbstractListModel>
+#include <QVector>
+
+class MultiDirModel;
+
+/**
+ * @brief The SyntheticSource class is an in-memory desktop folder for tests and benchmarks
+ *
+ * Items are made from a seed, so the same seed always gives the same name,
+ * type, size and time. Changes are reported with the same row signals a
+ * directory listing emits.
+ */
+class SyntheticSource : public QAbstractListModel, public DesktopItemSource {
+    Q_OBJECT
+
+public:
+    explicit SyntheticSource( int count = 0, QObject *parent = nullptr );
+    int rowCount( const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
+    Qt::ItemFlags flags( const QModelIndex &index ) const override;
+    QAbstractItemModel *model() override { return this; }
+    DesktopItem partialItem( int row ) const override { return this->items.at( row ); }
+    void setScale( int, qreal ) override {}
+    static DesktopItem make( int seed );
+    static bool settle( MultiDirModel *model );
+
+public slots:
+    void insert( int row, const DesktopItem &item );
+    void remove( int row );
+    void rename( int row, const QString &name );
+    void reset( int count );
+
+private:
+    QVector<DesktopItem> items;
+};
@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "multidirmodel.h"
+#include "sortmodel.h"
+#include "syntheticsource.h"
+#include <QtTest>
+
+/**
+ * @brief The OtherSource class stands in for the source type that was tried first and missed
+ */
+class OtherSource : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    int rowCount( const QModelIndex & = QModelIndex()) const override { return 0; }
+    QVariant data( const QModelIndex &, int = Qt::DisplayRole ) const override { return QVariant(); }
+};
+
+/**
+ * @brief castingItem reads an item the way the accessors did before the source adapter
+ * @param index of the multi directory model
+ * @return
+ *
+ * Every field is read on its own, each time casting the model to find out
+ * which source type the row came from.
+ */
+static DesktopItem castingItem( const QModelIndex &index ) {
+    const MultiDirModel *model( qobject_cast<const MultiDirModel *>( index.model()));
+    if ( model == nullptr )
+        return DesktopItem();
+
+    const QModelIndex sourceIndex( model->mapToSource( index ));
+    auto source = [ &sourceIndex ]() -> const SyntheticSource * {
+        if ( qobject_cast<const OtherSource *>( sourceIndex.model()) != nullptr )
+            return nullptr;
+
+        return qobject_cast<const SyntheticSource *>( sourceIndex.model());
+    };
+
+    DesktopItem item;
+    item.name = source()->partialItem( sourceIndex.row()).name;
+    item.path = source()->partialItem( sourceIndex.row()).path;
+    item.size = source()->partialItem( sourceIndex.row()).size;
+    item.lastModified = source()->partialItem( sourceIndex.row()).lastModified;
+    item.type = source()->partialItem( sourceIndex.row()).type;
+    item.flags = source()->partialItem( sourceIndex.row()).flags;
+    return item;
+}
+
+/**
+ * @brief The CastingSortModel class sorts by size with a cast on every comparison, as SortModel did
+ */
+class CastingSortModel : public QSortFilterProxyModel {
+    Q_OBJECT
+
+protected:
+    bool lessThan( const QModelIndex &left, const QModelIndex &right ) const override {
+        return castingItem( left ).size < castingItem( right ).size;
+    }
+};
+
+/**
+ * @brief The SourceAdapterTest class compares item access through DesktopItemSource with per-field casts
+ */
+class SourceAdapterTest : public QObject {
+    Q_OBJECT
+
+public:
+    enum Access {
+        Adapter,
+        Snapshot,
+        Cast
+    };
+    Q_ENUM( Access )
+
+private slots:
+    void sameItems();
+    void sameOrder();
+    void paint_data();
+    void paint();
+    void sort_data();
+    void sort();
+};
+
+/*
+ * rows for both benchmarks
+ */
+static constexpr const int Items = 10000;
+
+/**
+ * @brief SourceAdapterTest::sameItems checks that the adapter returns what the casts return
+ */
+void SourceAdapterTest::sameItems() {
+    SyntheticSource source( 500 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    for ( int y = 0; y < model.rowCount(); y++ ) {
+        const QModelIndex index( model.index( y, 0 ));
+        const DesktopItem item( model.item( index ));
+        const DesktopItem reference( castingItem( index ));
+
+        QCOMPARE( item.name, reference.name );
+        QCOMPARE( item.path, reference.path );
+        QCOMPARE( item.size, reference.size );
+        QCOMPARE( item.lastModified, reference.lastModified );
+        QCOMPARE( item.type, reference.type );
+        QCOMPARE( item.flags, reference.flags );
+    }
+}
+
+/**
+ * @brief SourceAdapterTest::sameOrder checks that both proxies sort by size alike
+ */
+void SourceAdapterTest::sameOrder() {
+    SyntheticSource source( 500 );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    SortModel sortModel;
+    sortModel.setSourceModel( &model );
+    sortModel.resort( SortModel::Size );
+
+    CastingSortModel castingModel;
+    castingModel.setSourceModel( &model );
+    castingModel.sort( 0 );
+
+    // sizes may repeat, compare sizes rather than rows
+    for ( int y = 0; y < model.rowCount(); y++ )
+        QCOMPARE( model.size( sortModel.mapToSource( sortModel.index( y, 0 ))), model.size( castingModel.mapToSource( castingModel.index( y, 0 ))));
+}
+
+/**
+ * @brief SourceAdapterTest::paint_data
+ */
+void SourceAdapterTest::paint_data() {
+    QTest::addColumn<Access>( "access" );
+
+    QTest::newRow( "adapter" ) << Adapter;
+    QTest::newRow( "snapshot" ) << Snapshot;
+    QTest::newRow( "cast" ) << Cast;
+}
+
+/**
+ * @brief SourceAdapterTest::paint benchmarks reading every field of every row, as a full repaint does
+ */
+void SourceAdapterTest::paint() {
+    QFETCH( Access, access );
+
+    SyntheticSource source( Items );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    // with a single source, model rows are source rows
+    const DesktopItemSource *adapter( &source );
+    qint64 total = 0;
+    QBENCHMARK {
+        for ( int y = 0; y < model.rowCount(); y++ ) {
+            if ( access == Adapter )
+                total += adapter->item( y ).size;
+            else if ( access == Snapshot )
+                total += model.item( model.index( y, 0 )).size;
+            else
+                total += castingItem( model.index( y, 0 )).size;
+        }
+    }
+    QVERIFY( total > 0 );
+}
+
+/**
+ * @brief SourceAdapterTest::sort_data
+ */
+void SourceAdapterTest::sort_data() {
+    QTest::addColumn<Access>( "access" );
+
+    QTest::newRow( "snapshot" ) << Snapshot;
+    QTest::newRow( "cast" ) << Cast;
+}
+
+/**
+ * @brief SourceAdapterTest::sort benchmarks sorting by size
+ */
+void SourceAdapterTest::sort() {
+    QFETCH( Access, access );
+
+    SyntheticSource source( Items );
+    MultiDirModel model;
+    model.add( &source );
+    QVERIFY( SyntheticSource::settle( &model ));
+
+    // a new proxy every time, sort() does nothing if column and order are unchanged
+    QBENCHMARK {
+        if ( access == Snapshot ) {
+            SortModel sortModel;
+            sortModel.setSourceModel( &model );
+            sortModel.resort( SortModel::Size );
+            QCOMPARE( sortModel.rowCount(), Items );
+        } else {
+            CastingSortModel castingModel;
+            castingModel.setSourceModel( &model );
+            castingModel.sort( 0 );
+            QCOMPARE( castingModel.rowCount(), Items );
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN( SourceAdapterTest )
+
+#include "tst_sourceadapter.moc"
@@ -0,0 +1,14 @@
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    alphascan \
+    iconpack \
+    mimecache \
+    multidirmodel \
+    sourceadapter \
+    fetch \
+    directoryindex \
+    namesort \
+    resort \
+    incrementalsort \
+    filter
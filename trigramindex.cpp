@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "trigramindex.h"
+#include <algorithm>
+#include <iterator>
+
+/**
+ * @brief TrigramIndex::trigrams
+ * @param folded case folded string
+ * @return unique trigrams packed into integers
+ */
+QVector<quint64> TrigramIndex::trigrams( const QString &folded ) {
+    QVector<quint64> grams;
+
+    for ( int y = 0; y + TrigramIndex::Length <= folded.length(); y++ )
+        grams << ( static_cast<quint64>( folded.at( y ).unicode()) << 32 | static_cast<quint64>( folded.at( y + 1 ).unicode()) << 16 | folded.at( y + 2 ).unicode());
+
+    std::sort( grams.begin(), grams.end());
+    grams.erase( std::unique( grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+/**
+ * @brief TrigramIndex::add
+ * @param id
+ * @param text
+ */
+void TrigramIndex::add( int id, const QString &text ) {
+    for ( const quint64 gram : TrigramIndex::trigrams( text.toCaseFolded())) {
+        QVector<int> &ids( this->postings[gram] );
+        if ( ids.isEmpty() || ids.last() != id )
+            ids << id;
+    }
+}
+
+/**
+ * @brief TrigramIndex::candidates
+ * @param text at least Length characters long
+ * @return sorted ids that contain every trigram of text
+ */
+QVector<int> TrigramIndex::candidates( const QString &text ) const {
+    QVector<const QVector<int> *> lists;
+
+    for ( const quint64 gram : TrigramIndex::trigrams( text.toCaseFolded())) {
+        const auto it = this->postings.constFind( gram );
+        if ( it == this->postings.constEnd())
+            return QVector<int>();
+
+        lists << &it.value();
+    }
+
+    if ( lists.isEmpty())
+        return QVector<int>();
+
+    // start from the rarest trigram, the result only gets smaller
+    std::sort( lists.begin(), lists.end(), []( const QVector<int> *left, const QVector<int> *right ) { return left->count() < right->count(); } );
+
+    QVector<int> ids( *lists.first());
+    for ( int y = 1; y < lists.count() && !ids.isEmpty(); y++ ) {
+        QVector<int> intersection;
+        std::set_intersection( ids.constBegin(), ids.constEnd(), lists.at( y )->constBegin(), lists.at( y )->constEnd(), std::back_inserter( intersection ));
+        ids = intersection;
+    }
+
+    return ids;
+}
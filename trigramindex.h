@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The TrigramIndex class finds strings by substring
+ *
+ * Every string is split into overlapping case folded three character
+ * sequences, each of which keeps a sorted list of the ids containing it.
+ * A query intersects the lists of its own trigrams; the result still has
+ * to be verified, since trigrams can match out of order. Ids must be
+ * added in increasing order.
+ */
+class TrigramIndex {
+public:
+    void add( int id, const QString &text );
+    QVector<int> candidates( const QString &text ) const;
+    void clear() { this->postings.clear(); }
+    static constexpr const int Length = 3;
+
+private:
+    static QVector<quint64> trigrams( const QString &folded );
+    QHash<quint64, QVector<int>> postings;
+};
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "updatescheduler.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QSettings>
+#include <QtMath>
+
+/**
+ * @brief UpdateScheduler::UpdateScheduler
+ * @param parent
+ */
+UpdateScheduler::UpdateScheduler( QObject *parent ) : QObject( parent ) {
+    this->setWindow( QSettings().value( "updates/window", 16 ).toInt());
+    this->timer.setSingleShot( true );
+    this->timer.setTimerType( Qt::PreciseTimer );
+    this->clock.start();
+
+    QTimer::connect( &this->timer, &QTimer::timeout, this, &UpdateScheduler::flush );
+}
+
+/**
+ * @brief UpdateScheduler::notify records a change, the first one in a window starts the timer
+ */
+void UpdateScheduler::notify() {
+    this->m_notifications++;
+
+    if ( this->timer.isActive())
+        return;
+
+    // wait out the window, then up to the next frame
+    const QScreen *screen( QGuiApplication::primaryScreen());
+    const qreal frame = 1000.0 / qMax( 1.0, screen != nullptr ? screen->refreshRate() : 60.0 );
+    const qint64 now = this->clock.elapsed();
+    const qint64 due = static_cast<qint64>( qCeil(( now + this->window()) / frame ) * frame );
+    this->timer.start( static_cast<int>( qMax( 0LL, due - now )));
+}
+
+/**
+ * @brief UpdateScheduler::flush applies pending notifications right away
+ */
+void UpdateScheduler::flush() {
+    this->timer.stop();
+    this->m_transactions++;
+    emit this->apply();
+}
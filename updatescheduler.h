@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+/**
+ * @brief The UpdateScheduler class coalesces change notifications into transactions
+ *
+ * Every notify() within a window is folded into a single apply() signal.
+ * The window (setting "updates/window", in ms) is rounded up to the next
+ * frame boundary of the primary screen, so a burst of notifications is
+ * applied at most once per painted frame.
+ */
+class UpdateScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    explicit UpdateScheduler( QObject *parent = nullptr );
+    int window() const { return this->m_window; }
+    bool isPending() const { return this->timer.isActive(); }
+    quint64 notifications() const { return this->m_notifications; }
+    quint64 transactions() const { return this->m_transactions; }
+
+public slots:
+    void notify();
+    void flush();
+    void setWindow( int window ) { this->m_window = qMax( 0, window ); }
+
+signals:
+    void apply();
+
+private:
+    QTimer timer;
+    QElapsedTimer clock;
+    int m_window = 16;
+    quint64 m_notifications = 0;
+    quint64 m_transactions = 0;
+};
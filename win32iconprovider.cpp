@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "win32iconprovider.h"
+#include "alphascan.h"
+#include <QDir>
+#include <QOperatingSystemVersion>
+#include <QVarLengthArray>
+#include <QtWin>
+#include <Windows.h>
+#include <CommCtrl.h>
+#include <commoncontrols.h>
+#include <shellapi.h>
+#include <WinUser.h>
+
+/**
+ * @brief Win32IconProvider::fileImage
+ * @param info
+ * @return icon at the largest size the shell provides (jumbo or large)
+ */
+QImage Win32IconProvider::fileImage( const QFileInfo &info, int ) const {
+    SHFILEINFO fileInfo;
+    QImage image;
+    int flags = SHGFI_ICON | SHGFI_SYSICONINDEX | SHGFI_LARGEICON;
+    bool ok = false;
+
+    memset( &fileInfo, 0, sizeof( SHFILEINFO ));
+
+    if ( !info.isDir())
+        flags |= SHGFI_USEFILEATTRIBUTES;
+
+    // win32 icon cache
+    const int hrFileInfo = static_cast<const int>( SHGetFileInfo( reinterpret_cast<const wchar_t *>( QDir::toNativeSeparators( info.absoluteFilePath()).utf16()), 0, &fileInfo, sizeof( SHFILEINFO ), static_cast<UINT>( flags )));
+
+    // for some reason this always fails on msvc
+#ifndef Q_CC_MSVC
+    if ( static_cast<const int>( hrFileInfo ) >= 0 )
+#else
+    Q_UNUSED( hrFileInfo )
+#endif
+    {
+        if ( QOperatingSystemVersion::current() >= QOperatingSystemVersion::Windows7 && fileInfo.hIcon ) {
+            /**
+             * @brief imageFromImageList
+             * @param index
+             * @param image
+             */
+            auto imageFromImageList = [ fileInfo ]( int index, QImage &image ) {
+                IImageList *imageList = nullptr;
+                HICON hIcon = nullptr;
+
+                if ( static_cast<int>( SHGetImageList( index, IID_PPV_ARGS( &imageList ))) >= 0 ) {
+                    if ( static_cast<int>( imageList->GetIcon( fileInfo.iIcon, ILD_TRANSPARENT, &hIcon )) >=0 ) {
+                        image = QtWin::imageFromHICON( hIcon );
+                        DestroyIcon( hIcon );
+                        imageList->Release();
+                    }
+                }
+            };
+
+            // first try to get the jumbo icon
+            imageFromImageList( 0x4, image );
+
+            // test if most of the image is blank (invalid jumbo with 48x48 on top left)
+            // or if the icon is really a small, but centered one
+            ok = AlphaScan::isJumbo( image );
+
+            // then try to get the large icon
+            if ( image.isNull() || !ok )
+                imageFromImageList( 0x2, image );
+        }
+
+        // if everything fails, get icon the old way
+        if ( image.isNull() && fileInfo.hIcon != nullptr ) {
+            image = QtWin::imageFromHICON( fileInfo.hIcon );
+            DestroyIcon( fileInfo.hIcon );
+        }
+    }
+
+    return image;
+}
+
+/**
+ * @brief Win32IconProvider::libraryImage
+ * @param resourceId
+ * @param size
+ * @param library
+ * @return
+ */
+QImage Win32IconProvider::libraryImage( int resourceId, int size, const QString &library ) const {
+    auto loadLibrary = []( const wchar_t *libraryName )  {
+        QVarLengthArray<wchar_t, MAX_PATH> fullPath;
+
+        UINT retLen = ::GetSystemDirectory( fullPath.data(), MAX_PATH );
+        if ( retLen > MAX_PATH ) {
+            fullPath.resize( static_cast<int>( retLen ));
+            retLen = ::GetSystemDirectory( fullPath.data(), retLen );
+        }
+
+        const QString systemDirectory( QString::fromWCharArray( fullPath.constData(), static_cast<int>( retLen )));
+        HINSTANCE inst = nullptr;
+        if ( !systemDirectory.isEmpty()) {
+            const QString fileName( QString::fromWCharArray( libraryName ).append( QLatin1String(".dll" )));
+            const QString absolutePath( systemDirectory + ( !systemDirectory.endsWith( "\\" ) ? "\\" : "" ) + fileName );
+
+            inst = ::LoadLibrary( reinterpret_cast<const wchar_t *>( absolutePath.utf16()));
+            if ( inst != nullptr )
+                return inst;
+        }
+
+        return inst;
+    };
+
+    if ( const HMODULE hmod = loadLibrary( reinterpret_cast<const wchar_t*>( QDir::toNativeSeparators( library ).utf16()))) {
+        const HICON hIcon = static_cast<HICON>( LoadImage( hmod, MAKEINTRESOURCE( resourceId ), IMAGE_ICON, size, size, 0 ));
+        if ( hIcon != nullptr ) {
+            const QImage image( QtWin::imageFromHICON( hIcon ));
+            DestroyIcon( hIcon );
+            return image;
+        }
+    }
+    return QImage();
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include "iconprovider.h"
+
+/**
+ * @brief The Win32IconProvider class extracts icons through the shell
+ */
+class Win32IconProvider : public IconProvider {
+public:
+    QImage fileImage( const QFileInfo &info, int size ) const override;
+    QImage libraryImage( int resourceId, int size, const QString &library ) const override;
+};
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+/*
+ * includes
+ */
+#include "xdgiconprovider.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QIcon>
+#include <QImageReader>
+#include <QLoggingCategory>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <climits>
+
+/*
+ * icon theme diagnostics, enable with QT_LOGGING_RULES="desktopview.xdg.debug=true"
+ */
+Q_LOGGING_CATEGORY( xdgLog, "desktopview.xdg", QtInfoMsg )
+
+/*
+ * split flag moved to the Qt namespace in 5.14, the old one is deprecated since 5.15
+ */
+#if QT_VERSION >= QT_VERSION_CHECK( 5, 14, 0 )
+static constexpr Qt::SplitBehaviorFlags SkipEmptyParts = Qt::SkipEmptyParts;
+#else
+static constexpr QString::SplitBehavior SkipEmptyParts = QString::SkipEmptyParts;
+#endif
+
+/**
+ * @brief XdgIconProvider::Directory::matches
+ * @param iconSize
+ * @return
+ */
+bool XdgIconProvider::Directory::matches( int iconSize ) const {
+    switch ( this->type ) {
+    case Fixed:
+        return this->size == iconSize;
+
+    case Scalable:
+        return this->minSize <= iconSize && iconSize <= this->maxSize;
+
+    case Threshold:
+        return this->size - this->threshold <= iconSize && iconSize <= this->size + this->threshold;
+    }
+
+    return false;
+}
+
+/**
+ * @brief XdgIconProvider::Directory::distance
+ * @param iconSize
+ * @return
+ */
+int XdgIconProvider::Directory::distance( int iconSize ) const {
+    switch ( this->type ) {
+    case Fixed:
+        return qAbs( this->size - iconSize );
+
+    case Scalable:
+        if ( iconSize < this->minSize )
+            return this->minSize - iconSize;
+
+        return iconSize > this->maxSize ? iconSize - this->maxSize : 0;
+
+    case Threshold:
+        if ( iconSize < this->size - this->threshold )
+            return this->size - this->threshold - iconSize;
+
+        return iconSize > this->size + this->threshold ? iconSize - this->size - this->threshold : 0;
+    }
+
+    return INT_MAX;
+}
+
+/**
+ * @brief XdgIconProvider::XdgIconProvider
+ */
+XdgIconProvider::XdgIconProvider() {
+    this->baseDirectories << QDir::homePath() + "/.icons";
+    for ( const QString &path : QStandardPaths::standardLocations( QStandardPaths::GenericDataLocation ))
+        this->baseDirectories << path + "/icons";
+
+    QString themeName( QSettings().value( "icons/theme" ).toString());
+    if ( themeName.isEmpty())
+        themeName = QIcon::themeName();
+
+    // the spec requires hicolor to be searched last
+    this->loadTheme( themeName.isEmpty() ? "hicolor" : themeName );
+    this->loadTheme( "hicolor" );
+
+    const QDir pixmapDir( "/usr/share/pixmaps" );
+    for ( const QFileInfo &info : pixmapDir.entryInfoList( QStringList() << "*.png" << "*.svg" << "*.xpm", QDir::Files ))
+        this->pixmaps.insert( info.completeBaseName(), info.absoluteFilePath());
+
+    int count = 0;
+    for ( const Theme &theme : qAsConst( this->themes ))
+        count += theme.icons.count();
+
+    qCDebug( xdgLog ) << "XdgIconProvider: indexed" << count << "icon names in" << this->themes.count() << "themes";
+}
+
+/**
+ * @brief XdgIconProvider::parse reads an ini style file (index.theme, .desktop)
+ * @param fileName
+ * @return keys grouped by section
+ */
+QHash<QString, XdgIconProvider::Section> XdgIconProvider::parse( const QString &fileName ) {
+    QHash<QString, Section> sections;
+    QFile file( fileName );
+
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ))
+        return sections;
+
+    QTextStream stream( &file );
+    stream.setCodec( "UTF-8" );
+
+    QString section;
+    while ( !stream.atEnd()) {
+        const QString line( stream.readLine().trimmed());
+
+        if ( line.isEmpty() || line.startsWith( '#' ) || line.startsWith( ';' ))
+            continue;
+
+        if ( line.startsWith( '[' ) && line.endsWith( ']' )) {
+            section = line.mid( 1, line.length() - 2 );
+            continue;
+        }
+
+        const int separator = line.indexOf( '=' );
+        if ( separator > 0 )
+            sections[section].insert( line.left( separator ).trimmed(), line.mid( separator + 1 ).trimmed());
+    }
+
+    return sections;
+}
+
+/**
+ * @brief XdgIconProvider::loadTheme indexes a theme and then the themes it inherits
+ * @param name
+ */
+void XdgIconProvider::loadTheme( const QString &name ) {
+    for ( const Theme &theme : qAsConst( this->themes )) {
+        if ( theme.name == name )
+            return;
+    }
+
+    QStringList roots;
+    QHash<QString, Section> index;
+    for ( const QString &base : qAsConst( this->baseDirectories )) {
+        const QString root( base + "/" + name );
+        if ( !QDir( root ).exists())
+            continue;
+
+        roots << root;
+        if ( index.isEmpty())
+            index = XdgIconProvider::parse( root + "/index.theme" );
+    }
+
+    if ( index.isEmpty())
+        return;
+
+    Theme theme;
+    theme.name = name;
+
+    const Section &info( index.value( "Icon Theme" ));
+    const QStringList directories( QString( info.value( "Directories" ) + "," + info.value( "ScaledDirectories" )).split( ',', SkipEmptyParts ));
+    for ( const QString &directory : directories ) {
+        const Section &section( index.value( directory ));
+        if ( section.isEmpty())
+            continue;
+
+        // scaled (HiDPI) directories hold larger pixmaps for the same nominal size
+        const int scale = qMax( 1, section.value( "Scale", "1" ).toInt());
+        Directory entry;
+        entry.size = section.value( "Size" ).toInt() * scale;
+        entry.minSize = section.value( "MinSize", section.value( "Size" )).toInt() * scale;
+        entry.maxSize = section.value( "MaxSize", section.value( "Size" )).toInt() * scale;
+        entry.threshold = section.value( "Threshold", "2" ).toInt();
+
+        const QString type( section.value( "Type", "Threshold" ));
+        entry.type = type == "Fixed" ? Directory::Fixed : ( type == "Scalable" ? Directory::Scalable : Directory::Threshold );
+
+        const int directoryIndex = theme.directories.count();
+        theme.directories << entry;
+
+        for ( const QString &root : qAsConst( roots )) {
+            const QDir dir( root + "/" + directory );
+            for ( const QFileInfo &file : dir.entryInfoList( QStringList() << "*.png" << "*.svg" << "*.xpm", QDir::Files ))
+                theme.icons[file.completeBaseName()] << Icon { directoryIndex, file.absoluteFilePath() };
+        }
+    }
+
+    this->themes << theme;
+
+    for ( const QString &parent : info.value( "Inherits" ).split( ',', SkipEmptyParts ))
+        this->loadTheme( parent.trimmed());
+}
+
+/**
+ * @brief XdgIconProvider::lookup
+ * @param name
+ * @param size
+ * @return path to the best matching icon file or an empty string
+ */
+QString XdgIconProvider::lookup( const QString &name, int size ) const {
+    for ( const Theme &theme : this->themes ) {
+        const auto it = theme.icons.constFind( name );
+        if ( it == theme.icons.constEnd())
+            continue;
+
+        QString closest;
+        int minimal = INT_MAX;
+        for ( const Icon &icon : it.value()) {
+            const Directory &directory( theme.directories.at( icon.directory ));
+            if ( directory.matches( size ))
+                return icon.path;
+
+            const int distance = directory.distance( size );
+            if ( distance < minimal ) {
+                minimal = distance;
+                closest = icon.path;
+            }
+        }
+
+        if ( !closest.isEmpty())
+            return closest;
+    }
+
+    return this->pixmaps.value( name );
+}
+
+/**
+ * @brief XdgIconProvider::load
+ * @param path
+ * @param size used for vector icons
+ * @return
+ */
+QImage XdgIconProvider::load( const QString &path, int size ) {
+    QImageReader reader( path );
+
+    if ( path.endsWith( ".svg" ))
+        reader.setScaledSize( QSize( size, size ));
+
+    return reader.read();
+}
+
+/**
+ * @brief XdgIconProvider::fileImage
+ * @param info
+ * @param size
+ * @return
+ */
+QImage XdgIconProvider::fileImage( const QFileInfo &info, int size ) const {
+    QStringList names;
+
+    if ( info.isDir()) {
+        names << "folder" << "inode-directory";
+    } else {
+        // launchers name their own icon
+        if ( info.suffix() == "desktop" ) {
+            const QString icon( XdgIconProvider::parse( info.absoluteFilePath()).value( "Desktop Entry" ).value( "Icon" ));
+            if ( QDir::isAbsolutePath( icon )) {
+                const QImage image( XdgIconProvider::load( icon, size ));
+                if ( !image.isNull())
+                    return image;
+            } else if ( !icon.isEmpty()) {
+                names << icon;
+            }
+        }
+
+        const QMimeType mime( this->mimeDatabase.mimeTypeForFile( info, QMimeDatabase::MatchExtension ));
+        names << mime.iconName() << mime.genericIconName();
+
+        if ( info.isExecutable())
+            names << "application-x-executable";
+
+        names << "text-x-generic" << "unknown";
+    }
+
+    for ( const QString &name : qAsConst( names )) {
+        const QString path( this->lookup( name, size ));
+        if ( path.isEmpty())
+            continue;
+
+        const QImage image( XdgIconProvider::load( path, size ));
+        if ( !image.isNull())
+            return image;
+    }
+
+    return QImage();
+}
+
+/**
+ * @brief XdgIconProvider::libraryImage maps the few windows stock icons in use to theme names
+ * @param resourceId
+ * @param size
+ * @param library
+ * @return
+ */
+QImage XdgIconProvider::libraryImage( int resourceId, int size, const QString &library ) const {
+    static const QHash<QString, QString> names {
+        { "shell32_16", "computer" },
+        { "shell32_32", "user-trash" },
+        { "shell32_267", "folder-documents" },
+        { "imageres_151", "preferences-desktop-wallpaper" }
+    };
+
+    const QString path( this->lookup( names.value( QString( "%1_%2" ).arg( library ).arg( resourceId )), size ));
+    return path.isEmpty() ? QImage() : XdgIconProvider::load( path, size );
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2020 Armands Aleksejevs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+/*
+ * includes
+ */
+#include "iconprovider.h"
+#include <QHash>
+#include <QMimeDatabase>
+#include <QVector>
+
+/**
+ * @brief The XdgIconProvider class resolves icons through the freedesktop icon theme spec
+ *
+ * The current theme, everything it inherits and hicolor are indexed once
+ * on construction (icon name to file, per theme directory); lookups only
+ * read that in-memory index, which is what makes the class thread safe.
+ */
+class XdgIconProvider : public IconProvider {
+public:
+    XdgIconProvider();
+    QImage fileImage( const QFileInfo &info, int size ) const override;
+    QImage libraryImage( int resourceId, int size, const QString &library ) const override;
+    QString lookup( const QString &name, int size ) const;
+
+private:
+    using Section = QHash<QString, QString>;
+
+    struct Directory {
+        enum Type {
+            Fixed,
+            Scalable,
+            Threshold
+        };
+
+        Type type;
+        int size;
+        int minSize;
+        int maxSize;
+        int threshold;
+
+        bool matches( int iconSize ) const;
+        int distance( int iconSize ) const;
+    };
+
+    struct Icon {
+        int directory;
+        QString path;
+    };
+
+    struct Theme {
+        QString name;
+        QVector<Directory> directories;
+        QHash<QString, QVector<Icon>> icons;
+    };
+
+    static QHash<QString, Section> parse( const QString &fileName );
+    static QImage load( const QString &path, int size );
+    void loadTheme( const QString &name );
+    QStringList baseDirectories;
+    QVector<Theme> themes;
+    QHash<QString, QString> pixmaps;
+    QMimeDatabase mimeDatabase;
+};